@@ -1,42 +1,2646 @@
 #pragma once
 
 #include <vector>
-#include <optional>
 #include <algorithm>
 #include <concepts>
 #include <cassert>
+#include <cstdint>
+#include <cmath>
+#include <memory>
+#include <utility>
+#include <iterator>
+#include <numeric>
+#include <stdexcept>
+#include <memory_resource>
+#include <exception>
+#include <ranges>
+#include <bit>
+#include <atomic>
+#include <span>
+#include <cstring>
+#include <istream>
+#include <ostream>
+
+// The overloads taking a std::execution policy are only declared if PALLA_VEC_LIST_PARALLEL is defined before including this header,
+// since <execution> makes some standard libraries depend on TBB at link time.
+#if defined(PALLA_VEC_LIST_PARALLEL)
+#include <execution>
+#include <thread>
+#endif
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <filesystem>
+#include <typeinfo>
+#include <system_error>
+#endif
 
 namespace palla {
     namespace details {
         namespace vec_list_namespace {
 
 
+            // Link policies for vec_list.
+
+            // Nodes are linked with raw pointers. This is the default and the fastest to traverse.
+            struct pointer_links {};
+
+            // Nodes are linked with 32-bit (bucket, offset) indices which are resolved through the list.
+            // This makes nodes smaller (12 bytes instead of 24 for an int) and the buckets relocatable.
+            // The drawbacks are that iterators refer to the list itself, so moving, swapping or splicing the list invalidates them,
+            // and that the list is limited to 30 buckets of 2^26 elements.
+            struct index_links {};
+
+
+            // Which free node an insertion uses. Free nodes are either holes left by erased elements or untouched nodes.
+            enum class hole_policy {
+                most_recent,    // The most recently erased node, or the next untouched node if there are no holes. This is the default and the fastest.
+                nearest,        // The free node closest to the insertion position within the same 64 nodes, so that neighbors in the list stay close in memory.
+                lowest_address, // The first free node of the first bucket which has one, so that elements gather in the earliest buckets and the later ones drain.
+            };
+
+
+            template<class T, class Links, class Allocator>
+            class vec_list_pool;
+
+
             // An std::list living inside a vector.
             // Allocates geometrically to reduce new's while still keeping every trait of std::list.
             // Keeps another (singlely-linked) list of holes when elements are erased and fills them back up later.
             // There is probably a clever way to do this using custom allocators on std::list.
+            // The allocator is rebound to allocate the nodes and the list of buckets, and used to construct the elements.
+            // The buckets and holes live in a separate storage which can be shared with other lists through a vec_list_pool.
+            template<class T, class Links = pointer_links, class Allocator = std::allocator<T>>
+            class vec_list {
+                static_assert(std::is_same_v<Links, pointer_links> || std::is_same_v<Links, index_links>, "Links must be pointer_links or index_links.");
+                static_assert(std::is_same_v<typename std::allocator_traits<Allocator>::value_type, T>, "Allocator::value_type must be T.");
+
+            private:
+                // Private types.
+                struct node;
+                friend class vec_list_pool<T, Links, Allocator>;
+
+                // Links are either pointers or (bucket, offset) indices.
+                static constexpr bool INDEX_LINKS = std::is_same_v<Links, index_links>;
+                using link = std::conditional_t<INDEX_LINKS, std::uint32_t, node*>;
+                using link_bits = std::conditional_t<INDEX_LINKS, std::uint32_t, std::uintptr_t>;
+
+                // Index link layout. The highest bit is reserved for the hole flag and the last bucket index is reserved for NULL_LINK.
+                // Bucket index 0 is reserved for the sentinel, which lives in the list itself.
+                static constexpr size_t OFFSET_BITS = 26;
+                static constexpr link_bits OFFSET_MASK = (link_bits(1) << OFFSET_BITS) - 1;
+                static constexpr size_t MAX_BUCKETS = INDEX_LINKS ? 31 : SIZE_MAX;
+                static constexpr size_t MAX_BUCKET_SIZE = INDEX_LINKS ? size_t(1) << OFFSET_BITS : SIZE_MAX;
+                static constexpr link NULL_LINK = [] { if constexpr (INDEX_LINKS) return link(0x7FFFFFFF); else return link(nullptr); }();
+                static constexpr link SENTINEL_LINK = [] { if constexpr (INDEX_LINKS) return link(0); else return link(nullptr); }();
+
+                // Whether a node is a hole is stored in a bit of prev which is never used by a valid link:
+                // the lowest bit for pointers since nodes are aligned, and the highest bit for indices.
+                static constexpr link_bits HOLE_FLAG = INDEX_LINKS ? link_bits(1) << 31 : link_bits(1);
+
+                static link_bits to_bits(link l) { if constexpr (INDEX_LINKS) return l; else return reinterpret_cast<link_bits>(l); }
+                static link from_bits(link_bits bits) { if constexpr (INDEX_LINKS) return bits; else return reinterpret_cast<link>(bits); }
+
+                // Struct for elements. A node is exactly 2 links and a T.
+                struct node {
+                    link next = NULL_LINK;
+                    link_bits prev_and_flag = to_bits(NULL_LINK);
+                    union { T elem; };  // Only alive when the node is not a hole.
+
+                    node() {}
+                    ~node() {}
+
+                    link prev() const { return from_bits(prev_and_flag & ~HOLE_FLAG); }
+                    void set_prev(link prev) { prev_and_flag = to_bits(prev) | (prev_and_flag & HOLE_FLAG); }
+                    bool is_hole() const { return prev_and_flag & HOLE_FLAG; }
+                    void set_hole(bool is_hole) { prev_and_flag = (prev_and_flag & ~HOLE_FLAG) | (is_hole ? HOLE_FLAG : 0); }
+                };
+                static_assert(INDEX_LINKS || alignof(node) > HOLE_FLAG, "The hole flag must fit in the unused bits of a node pointer.");
+
+                // Nodes of a bucket shared with snapshots. They are never modified again and are freed along with their last owner.
+                struct frozen_nodes {
+                    node* nodes = nullptr;
+                    size_t size = 0;
+                    size_t initialized = 0;
+                    bool huge_pages = false;
+                    std::atomic<size_t> nb_owners = 1;  // The list, if the bucket still uses these nodes, and every snapshot. Snapshots can be released on other threads.
+                };
+
+                // Pointer links don't support snapshots, so their buckets don't pay for the pointer to the frozen nodes.
+                struct no_frozen_nodes {
+                    constexpr operator frozen_nodes*() const { return nullptr; }
+                    constexpr no_frozen_nodes& operator=(std::nullptr_t) { return *this; }
+                };
+
+                // Struct for buckets. The memory is allocated uninitialized and nodes are only constructed when they are first used,
+                // so growing never touches memory which is not needed yet.
+                // Each bucket also has a bitmap of the nodes which hold an element, so scans can skip 64 holes at a time.
+                // Like the nodes, a word of the bitmap is only initialized once its first node is touched.
+                struct bucket {
+                    node* nodes = nullptr;
+                    size_t size = 0;
+                    size_t initialized = 0;                 // Nodes at or past this index are untouched. They count as holes but are not part of the hole list.
+                    std::uint64_t* occupied = nullptr;      // One bit per node. Only the words holding initialized nodes are valid.
+                    size_t nb_occupied = 0;                 // Number of nodes holding an element.
+                    size_t first_free = 0;                  // There are no holes or untouched nodes before this index.
+                    bool huge_pages = false;                // Whether the nodes were mapped on huge pages instead of allocated through the allocator.
+                    [[no_unique_address]] std::conditional_t<INDEX_LINKS, frozen_nodes*, no_frozen_nodes> frozen = {};  // Set if the nodes are shared with snapshots. They are then copied before being modified.
+                };
+                static constexpr size_t BITS_PER_WORD = 64;
+
+                // Allocator types.
+                using allocator_traits = std::allocator_traits<Allocator>;
+                template<class U>
+                using rebind_allocator = typename allocator_traits::template rebind_alloc<U>;
+                template<class U>
+                using rebind_vector = std::vector<U, rebind_allocator<U>>;
+                using node_allocator_traits = std::allocator_traits<rebind_allocator<node>>;
+                static_assert(std::is_same_v<typename node_allocator_traits::pointer, node*>, "Allocators with fancy pointers are not supported.");
+
+                static constexpr bool ALLOCATOR_PROPAGATES_ON_COPY = allocator_traits::propagate_on_container_copy_assignment::value;
+                static constexpr bool ALLOCATOR_PROPAGATES_ON_MOVE = allocator_traits::propagate_on_container_move_assignment::value || allocator_traits::is_always_equal::value;
+                static constexpr bool ALLOCATOR_PROPAGATES_ON_SWAP = allocator_traits::propagate_on_container_swap::value || allocator_traits::is_always_equal::value;
+
+                // Where optimize_step() resumes. Positions count the nodes of the buckets sorted by decreasing size.
+                struct compaction_cursor {
+                    size_t low = 0;             // Holes before this position have already been filled.
+                    size_t high = SIZE_MAX;     // Elements at or past this position have already been moved.
+                    size_t nb_buckets = 0;      // The positions are only valid for the buckets they were computed with.
+                    bool moved = false;         // Whether the current pass moved anything. A pass which moves nothing means the list is compact.
+                };
+
+                // Where the nodes of a bucket start, to find the bucket of a pointer link.
+                struct bucket_address {
+                    std::uintptr_t first = 0;
+                    size_t bucket_index = 0;
+                };
+                static constexpr size_t MAX_LINEAR_LOCATE_BUCKETS = 8;  // Past this many buckets, pointer links are located with a binary search instead of a linear one.
+
+                // The buckets and the holes. Every list of a pool shares the same storage, and it is freed along with its last owner.
+                struct node_storage {
+                    rebind_vector<bucket> buckets;  // List of buckets. Released buckets stay as empty slots until reused, since index links refer to bucket indices. The first bucket is always empty since index 0 is the sentinel. Also holds the allocator.
+                    link first_hole = NULL_LINK;    // First hole. Holes form a forward list embedded within this list. When an element is erased, it becomes the new first hole.
+                    link last_hole = NULL_LINK;     // Last hole. Used for splicing lists together.
+                    size_t frontier = 0;            // Bucket whose untouched nodes are used when the hole list is empty. 0 if there are no untouched nodes.
+                    size_t size = 0;                // Number of elements of every list using this storage.
+                    size_t capacity = 0;            // Number of elements and holes, including untouched nodes.
+                    size_t nb_owners = 1;           // Number of lists (and pools) using this storage.
+                    compaction_cursor compaction;   // Progress of optimize_step().
+                    hole_policy policy = hole_policy::most_recent;
+                    bool auto_release = false;      // Whether buckets are freed as soon as their last element is erased.
+                    bool huge_pages = false;        // Whether new buckets of at least HUGE_PAGE_SIZE bytes are mapped on huge pages.
+                    size_t auto_release_min_free = 0;   // Buckets are only freed automatically if at least this many free nodes remain.
+                    bucket_address* by_address = nullptr;   // With pointer links and more than MAX_LINEAR_LOCATE_BUCKETS buckets, the buckets sorted by address. Empty otherwise.
+                    std::uint32_t nb_addresses = 0;         // Number of buckets in by_address.
+                    std::uint32_t address_capacity = 0;     // Number of buckets by_address can hold.
+
+                    explicit node_storage(const Allocator& allocator) : buckets(1, bucket{}, allocator) {}
+                };
+                using storage_allocator_traits = std::allocator_traits<rebind_allocator<node_storage>>;
+
+                // Iterators, templated for constness.
+                template<class U>
+                class iterator_impl {
+                private:
+                    // Private constructor so vec_list can create a valid iterator.
+                    friend class vec_list;
+                    template<class> friend class iterator_impl;
+                    explicit iterator_impl(link link, const vec_list* list) : m_link(link) { if constexpr (INDEX_LINKS) m_list = list; }
+
+                    // Index links need the list to be resolved.
+                    struct no_list {};
+                    using list_pointer = std::conditional_t<INDEX_LINKS, const vec_list*, no_list>;
+
+                    node& get() const { if constexpr (INDEX_LINKS) return m_list->at(m_link); else return *m_link; }
+                    const node& peek() const { if constexpr (INDEX_LINKS) return m_list->peek(m_link); else return *m_link; }
+                    const vec_list* list() const { if constexpr (INDEX_LINKS) return m_list; else return nullptr; }
+
+                    // Private members.
+                    link m_link = NULL_LINK;                    // The iterator is basically a wrapper around a node.
+                    [[no_unique_address]] list_pointer m_list;  // Only used for index links.
+
+                public:
+                    // Types required to satisfy std::bidirectional_iterator.
+                    using difference_type = std::ptrdiff_t;
+                    using value_type = U;
+
+                    // Default constructor. The user can only create empty iterators.
+                    iterator_impl() = default;
+
+                    // Indirection. Only mutable iterators copy buckets shared with snapshots.
+                    U& operator*() const { if constexpr (std::is_const_v<U>) return peek().elem; else return get().elem; }
+                    U* operator->() const { return &**this; }
+
+                    // Increment and decrement.
+                    iterator_impl& operator++() { assert(peek().next != NULL_LINK); m_link = peek().next; return *this; }
+                    iterator_impl operator++(int) { iterator_impl current = *this; ++(*this); return current; }
+
+                    iterator_impl& operator--() { assert(peek().prev() != NULL_LINK); m_link = peek().prev(); return *this; }
+                    iterator_impl operator--(int) { iterator_impl current = *this; --(*this); return current; }
+
+                    // Comparison.
+                    friend bool operator==(const iterator_impl& a, const iterator_impl& b) { return a.m_link == b.m_link; }
+
+                    // Conversion from mutable to const.
+                    operator iterator_impl<const U>() const requires (!std::is_const_v<U>) { return iterator_impl<const U>(m_link, list()); }
+
+                };
+
+                // Forward iterator over the elements in memory order, templated for constness. It scans the buckets and skips holes.
+                // If other lists have elements in the same storage, their nodes cannot be told apart, so it follows the links instead.
+                template<class U>
+                class unordered_iterator_impl {
+                private:
+                    // Private constructor so vec_list can create a valid iterator.
+                    friend class vec_list;
+                    template<class> friend class unordered_iterator_impl;
+                    explicit unordered_iterator_impl(const vec_list* list, node* n, size_t bucket_index) : m_list(list), m_node(n), m_bucket_index(bucket_index) {
+                        if (m_bucket_index != 0)
+                            skip_holes();
+                    }
+
+                    // Moves to the next element of the buckets, or to the sentinel past the last bucket.
+                    void skip_holes() {
+                        auto& buckets = m_list->m_storage->buckets;
+                        while (true) {
+                            auto& bucket = buckets[m_bucket_index];
+                            size_t elem_index = find_occupied(bucket, m_node - bucket.nodes);
+                            if (elem_index != bucket.initialized) {
+                                m_node = bucket.nodes + elem_index;
+                                return;
+                            }
+                            if (++m_bucket_index == buckets.size()) {
+                                m_node = &m_list->m_sentinel;
+                                m_bucket_index = 0;
+                                return;
+                            }
+                            m_node = buckets[m_bucket_index].nodes;
+                        }
+                    }
+
+                    // Private members.
+                    const vec_list* m_list = nullptr;
+                    node* m_node = nullptr;             // The sentinel once past the last element, in both modes.
+                    size_t m_bucket_index = 0;          // Bucket 0 is never scanned, so 0 means the links are followed.
+
+                public:
+                    // Types required to satisfy std::forward_iterator.
+                    using difference_type = std::ptrdiff_t;
+                    using value_type = U;
+
+                    // Default constructor. The user can only create empty iterators.
+                    unordered_iterator_impl() = default;
+
+                    // Indirection.
+                    U& operator*() const { return m_node->elem; }
+                    U* operator->() const { return &**this; }
+
+                    // Increment.
+                    unordered_iterator_impl& operator++() {
+                        if (m_bucket_index == 0) {
+                            m_node = &m_list->peek(m_node->next);
+                        }
+                        else {
+                            ++m_node;
+                            skip_holes();
+                        }
+                        return *this;
+                    }
+                    unordered_iterator_impl operator++(int) { unordered_iterator_impl current = *this; ++(*this); return current; }
+
+                    // Comparison.
+                    friend bool operator==(const unordered_iterator_impl& a, const unordered_iterator_impl& b) { return a.m_node == b.m_node; }
+
+                    // Conversion from mutable to const.
+                    operator unordered_iterator_impl<const U>() const requires (!std::is_const_v<U>) {
+                        unordered_iterator_impl<const U> it;
+                        it.m_list = m_list;
+                        it.m_node = m_node;
+                        it.m_bucket_index = m_bucket_index;
+                        return it;
+                    }
+
+                };
+
+
+                // Private members.
+                [[no_unique_address]] Allocator m_allocator;
+                node_storage* m_storage = nullptr;  // Buckets and holes, possibly shared with other lists. Only allocated once an element is added.
+                mutable node m_sentinel;            // Circular sentinel. Its next is the first element and its prev is the last one. It is both begin and end.
+                size_t m_size = 0;                  // Number of elements (not holes) in this list.
+
+                // Expansion constants.
+                static constexpr size_t MIN_BUCKET_SIZE = 16;
+                static constexpr double GROWTH_FACTOR = 2;
+
+                // Buckets are only mapped on huge pages if they fill at least one.
+                static constexpr size_t HUGE_PAGE_SIZE = size_t(1) << 21;
+
+                // The header written by serialize().
+                struct serialization_header {
+                    std::uint64_t size = 0;
+                    std::uint64_t elem_size = 0;
+                };
+
+                // serialize() writes and deserialize() reads this many elements at a time.
+                static constexpr size_t SERIALIZATION_CHUNK_SIZE = size_t(1) << 14;
+
+                static void check_serialization_header(const serialization_header& header) {
+                    if (header.elem_size != sizeof(T))
+                        throw std::runtime_error("The serialized vec_list was written with another element size.");
+                }
+
+#if defined(PALLA_VEC_LIST_PARALLEL)
+                // Parallel algorithms don't start a thread for less than this many elements.
+                static constexpr size_t MIN_PARALLEL_CHUNK_SIZE = size_t(1) << 17;
+
+                // Only these policies allow running on other threads. The others, like unseq, must stay on the calling thread.
+                template<class ExecutionPolicy>
+                static constexpr bool IS_PARALLEL_POLICY = std::is_same_v<ExecutionPolicy, std::execution::parallel_policy> || std::is_same_v<ExecutionPolicy, std::execution::parallel_unsequenced_policy>;
+
+                // Maximum number of threads of parallel algorithms. Defining PALLA_VEC_LIST_MAX_THREADS overrides the number of hardware threads.
+                static size_t max_threads() {
+#if defined(PALLA_VEC_LIST_MAX_THREADS)
+                    return PALLA_VEC_LIST_MAX_THREADS;
+#else
+                    return std::thread::hardware_concurrency();
+#endif
+                }
+#endif
+
+                // Private functions.
+
+                // Resolves a link to modify its node. Index links first copy buckets shared with snapshots.
+                node& at(link l) const {
+                    if constexpr (INDEX_LINKS) {
+                        assert(l != NULL_LINK);
+                        if (l == SENTINEL_LINK)
+                            return m_sentinel;
+                        auto& bucket = m_storage->buckets[l >> OFFSET_BITS];
+                        if (bucket.frozen != nullptr) [[unlikely]]
+                            const_cast<vec_list*>(this)->thaw(l >> OFFSET_BITS);
+                        return bucket.nodes[l & OFFSET_MASK];
+                    }
+                    else {
+                        return *l;
+                    }
+                }
+
+                // Resolves a link without copying buckets shared with snapshots. Read-only paths must use this so they never move elements,
+                // which also keeps concurrent const reads safe. The node may only be modified if its bucket is not shared, for example after thaw_all().
+                node& peek(link l) const {
+                    if constexpr (INDEX_LINKS) {
+                        assert(l != NULL_LINK);
+                        if (l == SENTINEL_LINK)
+                            return m_sentinel;
+                        return m_storage->buckets[l >> OFFSET_BITS].nodes[l & OFFSET_MASK];
+                    }
+                    else {
+                        return *l;
+                    }
+                }
+
+                // Creates the link of a node.
+                link make_link(size_t bucket_index, size_t elem_index) const {
+                    if constexpr (INDEX_LINKS)
+                        return link((bucket_index << OFFSET_BITS) | elem_index);
+                    else
+                        return m_storage->buckets[bucket_index].nodes + elem_index;
+                }
+
+                // Index links only. Maps the bucket index of a link. The sentinel and NULL_LINK are left alone.
+                template<class F>
+                static link relabel(link l, F&& new_bucket_index) {
+                    if (l == NULL_LINK || (l >> OFFSET_BITS) == 0)
+                        return l;
+                    return link((new_bucket_index(l >> OFFSET_BITS) << OFFSET_BITS) | (l & OFFSET_MASK));
+                }
+
+                template<class F>
+                static void relabel(node& n, F&& new_bucket_index) {
+                    n.next = relabel(n.next, new_bucket_index);
+                    n.set_prev(relabel(n.prev(), new_bucket_index));
+                }
+
+                // The link of the sentinel, which is end() and whose next is begin().
+                link end_link() const { if constexpr (INDEX_LINKS) return SENTINEL_LINK; else return &m_sentinel; }
+
+                // Creates an iterator.
+                iterator_impl<T> make_iterator(link l) const { return iterator_impl<T>(l, this); }
+
+                // The buckets can only be scanned in memory order if every element of the storage belongs to this list.
+                bool owns_every_element() const { return m_storage == nullptr || m_storage->size == m_size; }
+
+                // Creates the first unordered iterator.
+                unordered_iterator_impl<T> make_unordered_begin() const {
+                    if (m_size == 0)
+                        return unordered_iterator_impl<T>(this, &m_sentinel, 0);
+                    if (!owns_every_element())
+                        return unordered_iterator_impl<T>(this, &peek(m_sentinel.next), 0);
+                    return unordered_iterator_impl<T>(this, m_storage->buckets[1].nodes, 1);
+                }
+
+                // Calls f on every node which holds an element of this list, in memory order if possible.
+                template<class F>
+                void for_each_node_unordered(F&& f) const {
+                    if (m_size == 0)
+                        return;
+                    if (!owns_every_element()) {
+                        for (auto current = m_sentinel.next, last = end_link(); current != last; current = peek(current).next)
+                            f(peek(current));
+                        return;
+                    }
+                    for (size_t i = 1; i < m_storage->buckets.size(); i++)
+                        for_each_occupied_node(m_storage->buckets[i], 0, nb_bitmap_words(m_storage->buckets[i]), f);
+                }
+
+                // Calls f on every node which holds an element in the given words of the bitmap of a bucket.
+                template<class F>
+                static void for_each_occupied_node(const bucket& bucket, size_t first_word, size_t last_word, F&& f) {
+                    for (size_t word = first_word; word < last_word; word++) {
+                        for (auto bits = bucket.occupied[word]; bits != 0; bits &= bits - 1)
+                            f(bucket.nodes[word * BITS_PER_WORD + std::countr_zero(bits)]);
+                    }
+                }
+
+                // Number of valid words in the bitmap of a bucket.
+                static size_t nb_bitmap_words(const bucket& bucket) { return (bucket.initialized + BITS_PER_WORD - 1) / BITS_PER_WORD; }
+
+#if defined(PALLA_VEC_LIST_PARALLEL)
+                // Calls f on every node which holds an element of this list, on multiple threads if the list is large enough.
+                template<class ExecutionPolicy, class F>
+                void parallel_for_each_node_unordered(F&& f) const {
+                    size_t nb_chunks = std::min<size_t>(max_threads(), m_size / MIN_PARALLEL_CHUNK_SIZE);
+                    if (!IS_PARALLEL_POLICY<ExecutionPolicy> || nb_chunks < 2 || !owns_every_element())
+                        return for_each_node_unordered(f);
+
+                    // Each chunk covers a range of words over the concatenated bitmaps.
+                    auto& buckets = m_storage->buckets;
+                    size_t nb_words = 0;
+                    for (size_t i = 1; i < buckets.size(); i++)
+                        nb_words += nb_bitmap_words(buckets[i]);
+                    run_in_parallel(nb_chunks, [&](size_t chunk) {
+                        size_t first = nb_words * chunk / nb_chunks, last = nb_words * (chunk + 1) / nb_chunks;
+                        size_t offset = 0;
+                        for (size_t i = 1; i < buckets.size() && offset < last; i++) {
+                            size_t bucket_words = nb_bitmap_words(buckets[i]);
+                            if (offset + bucket_words > first)
+                                for_each_occupied_node(buckets[i], std::max(first, offset) - offset, std::min(last, offset + bucket_words) - offset, f);
+                            offset += bucket_words;
+                        }
+                    });
+                }
+#endif
+
+                // Returns the index of the first node at or after elem_index which holds an element, or the number of initialized nodes if there are none.
+                static size_t find_occupied(const bucket& bucket, size_t elem_index) {
+                    if (elem_index >= bucket.initialized)
+                        return bucket.initialized;
+                    size_t nb_words = nb_bitmap_words(bucket);
+                    size_t word = elem_index / BITS_PER_WORD;
+                    auto bits = bucket.occupied[word] & (~std::uint64_t(0) << (elem_index % BITS_PER_WORD));
+                    while (bits == 0) {
+                        if (++word == nb_words)
+                            return bucket.initialized;
+                        bits = bucket.occupied[word];
+                    }
+                    return word * BITS_PER_WORD + std::countr_zero(bits);
+                }
+
+                // Number of buckets which have not been released.
+                size_t nb_allocated_buckets() const {
+                    return std::ranges::count_if(m_storage->buckets, [](const bucket& b) { return b.nodes != nullptr; });
+                }
+
+                // Makes sure the table of the buckets sorted by address can hold nb_buckets, so that updating it afterwards cannot throw.
+                void reserve_bucket_addresses(size_t nb_buckets) {
+                    auto& storage = *m_storage;
+                    if (INDEX_LINKS || nb_buckets <= MAX_LINEAR_LOCATE_BUCKETS || nb_buckets <= storage.address_capacity)
+                        return;
+                    rebind_allocator<bucket_address> allocator(storage.buckets.get_allocator());
+                    auto by_address = std::allocator_traits<rebind_allocator<bucket_address>>::allocate(allocator, 2 * nb_buckets);
+                    std::copy_n(storage.by_address, storage.nb_addresses, by_address);
+                    auto nb_addresses = storage.nb_addresses;
+                    deallocate_bucket_addresses();
+                    storage.by_address = by_address;
+                    storage.nb_addresses = nb_addresses;
+                    storage.address_capacity = std::uint32_t(2 * nb_buckets);
+                }
+
+                // Rebuilds the table of the buckets sorted by address after buckets were freed or moved. Its capacity must already be reserved.
+                // Lists with few buckets don't have one since a linear search from the largest bucket is faster.
+                void index_bucket_addresses() noexcept {
+                    if constexpr (!INDEX_LINKS) {
+                        auto& storage = *m_storage;
+                        auto& buckets = storage.buckets;
+                        if (nb_allocated_buckets() <= MAX_LINEAR_LOCATE_BUCKETS) {
+                            deallocate_bucket_addresses();
+                            return;
+                        }
+                        storage.nb_addresses = 0;
+                        for (size_t bucket_index = 1; bucket_index < buckets.size(); bucket_index++) {
+                            if (buckets[bucket_index].nodes != nullptr)
+                                storage.by_address[storage.nb_addresses++] = { reinterpret_cast<std::uintptr_t>(buckets[bucket_index].nodes), bucket_index };
+                        }
+                        assert(storage.nb_addresses <= storage.address_capacity);
+                        std::sort(storage.by_address, storage.by_address + storage.nb_addresses, [](const bucket_address& a, const bucket_address& b) { return a.first < b.first; });
+                    }
+                }
+
+                // Adds a new bucket to the table of the buckets sorted by address. Its capacity must already be reserved.
+                void insert_bucket_address(size_t bucket_index) noexcept {
+                    if constexpr (!INDEX_LINKS) {
+                        auto& storage = *m_storage;
+                        if (storage.nb_addresses == 0) {
+                            index_bucket_addresses();
+                            return;
+                        }
+                        bucket_address entry{ reinterpret_cast<std::uintptr_t>(storage.buckets[bucket_index].nodes), bucket_index };
+                        auto end = storage.by_address + storage.nb_addresses;
+                        auto it = std::upper_bound(storage.by_address, end, entry.first, [](std::uintptr_t a, const bucket_address& b) { return a < b.first; });
+                        assert(storage.nb_addresses < storage.address_capacity);
+                        std::copy_backward(it, end, end + 1);
+                        *it = entry;
+                        storage.nb_addresses++;
+                    }
+                }
+
+                void deallocate_bucket_addresses() noexcept {
+                    auto& storage = *m_storage;
+                    if (storage.by_address != nullptr) {
+                        rebind_allocator<bucket_address> allocator(storage.buckets.get_allocator());
+                        std::allocator_traits<rebind_allocator<bucket_address>>::deallocate(allocator, storage.by_address, storage.address_capacity);
+                    }
+                    storage.by_address = nullptr;
+                    storage.nb_addresses = storage.address_capacity = 0;
+                }
+
+                // Finds the bucket and the index of a node. Pointers are searched from the last bucket since the largest buckets are usually the most recent,
+                // or binary searched among the buckets sorted by address if there are many.
+                std::pair<size_t, size_t> locate(link l) const {
+                    if constexpr (INDEX_LINKS) {
+                        return { l >> OFFSET_BITS, l & OFFSET_MASK };
+                    }
+                    else {
+                        auto& storage = *m_storage;
+                        auto& buckets = storage.buckets;
+                        auto address = reinterpret_cast<std::uintptr_t>(l);
+                        auto contains = [&](size_t bucket_index) {
+                            auto first = reinterpret_cast<std::uintptr_t>(buckets[bucket_index].nodes);
+                            return address >= first && address < first + buckets[bucket_index].size * sizeof(node);
+                        };
+                        if (storage.nb_addresses != 0 && !contains(buckets.size() - 1)) {
+                            auto it = std::upper_bound(storage.by_address, storage.by_address + storage.nb_addresses, address, [](std::uintptr_t a, const bucket_address& b) { return a < b.first; });
+                            assert(it != storage.by_address);
+                            size_t bucket_index = std::prev(it)->bucket_index;
+                            assert(l >= buckets[bucket_index].nodes && l < buckets[bucket_index].nodes + buckets[bucket_index].size);
+                            return { bucket_index, size_t(l - buckets[bucket_index].nodes) };
+                        }
+                        for (size_t bucket_index = buckets.size() - 1; bucket_index > 0; bucket_index--) {
+                            if (contains(bucket_index))
+                                return { bucket_index, size_t(l - buckets[bucket_index].nodes) };
+                        }
+                        assert(false);
+                        return { 0, 0 };
+                    }
+                }
+
+                // Marks a node as holding an element or not in the bitmap of its bucket. Returns the index of the bucket.
+                size_t set_occupied(link l, bool occupied) {
+                    auto [bucket_index, elem_index] = locate(l);
+                    set_occupied(bucket_index, elem_index, occupied);
+                    return bucket_index;
+                }
+                void set_occupied(size_t bucket_index, size_t elem_index, bool occupied) {
+                    auto& bucket = m_storage->buckets[bucket_index];
+                    auto& word = bucket.occupied[elem_index / BITS_PER_WORD];
+                    auto bit = std::uint64_t(1) << (elem_index % BITS_PER_WORD);
+                    if (occupied) {
+                        word |= bit;
+                        bucket.nb_occupied++;
+                    }
+                    else {
+                        word &= ~bit;
+                        bucket.nb_occupied--;
+                        bucket.first_free = std::min(bucket.first_free, elem_index);
+                    }
+                }
+
+                // Marks the initialized nodes of a bucket as the only occupied ones.
+                static void set_initialized_occupied(bucket& bucket) {
+                    size_t nb_full_words = bucket.initialized / BITS_PER_WORD;
+                    std::fill_n(bucket.occupied, nb_full_words, ~std::uint64_t(0));
+                    if (bucket.initialized % BITS_PER_WORD != 0)
+                        bucket.occupied[nb_full_words] = (std::uint64_t(1) << (bucket.initialized % BITS_PER_WORD)) - 1;
+                    bucket.nb_occupied = bucket.initialized;
+                    bucket.first_free = bucket.initialized;
+                }
+
+                // Constructs the first untouched node of a bucket, along with its word of the bitmap. Does not increment bucket.initialized.
+                void touch_node(size_t bucket_index) {
+                    auto& bucket = writable_bucket(bucket_index);
+                    if (bucket.initialized % BITS_PER_WORD == 0)
+                        bucket.occupied[bucket.initialized / BITS_PER_WORD] = 0;
+                    std::construct_at(bucket.nodes + bucket.initialized);
+                }
+
+                // Allocates a new storage owned only by the caller.
+                static node_storage* make_storage(const Allocator& allocator) {
+                    rebind_allocator<node_storage> storage_allocator(allocator);
+                    auto storage = storage_allocator_traits::allocate(storage_allocator, 1);
+                    try {
+                        storage_allocator_traits::construct(storage_allocator, storage, allocator);
+                    }
+                    catch (...) {
+                        storage_allocator_traits::deallocate(storage_allocator, storage, 1);
+                        throw;
+                    }
+                    return storage;
+                }
+
+                // Creates the storage on first use, so that empty lists don't allocate.
+                node_storage& get_storage() {
+                    if (m_storage == nullptr)
+                        m_storage = make_storage(m_allocator);
+                    return *m_storage;
+                }
+
+                // Gives up ownership of the storage, and frees it if this was the last owner. This list must already be empty.
+                void release_storage() {
+                    assert(empty());
+                    if (m_storage == nullptr)
+                        return;
+                    if (--m_storage->nb_owners == 0) {
+                        for (auto& bucket : m_storage->buckets)
+                            deallocate_bucket(bucket);
+                        deallocate_bucket_addresses();
+                        rebind_allocator<node_storage> storage_allocator(m_storage->buckets.get_allocator());
+                        storage_allocator_traits::destroy(storage_allocator, m_storage);
+                        storage_allocator_traits::deallocate(storage_allocator, m_storage, 1);
+                    }
+                    m_storage = nullptr;
+                }
+
+                // Whether another list can have elements or holes in the storage.
+                bool is_storage_shared() const { return m_storage != nullptr && m_storage->nb_owners > 1; }
+
+                // Returns the first slot of a released bucket, or the number of buckets if there are none.
+                size_t find_released_bucket() const {
+                    auto& buckets = m_storage->buckets;
+                    for (size_t bucket_index = 1; bucket_index < buckets.size(); bucket_index++) {
+                        if (buckets[bucket_index].nodes == nullptr)
+                            return bucket_index;
+                    }
+                    return buckets.size();
+                }
+
+                // Allocates a new bucket without initializing it. The slot of a released bucket is reused if there is one. Returns the index of the bucket.
+                size_t add_bucket(size_t size) {
+                    auto& buckets = m_storage->buckets;
+                    size_t bucket_index = find_released_bucket();
+                    if (bucket_index == buckets.size())
+                        buckets.reserve(buckets.size() + 1);
+                    reserve_bucket_addresses(nb_allocated_buckets() + 1);
+                    rebind_allocator<node> allocator(buckets.get_allocator());
+                    rebind_allocator<std::uint64_t> bitmap_allocator(buckets.get_allocator());
+                    bucket new_bucket{ nullptr, size };
+                    if (m_storage->huge_pages && size * sizeof(node) >= HUGE_PAGE_SIZE)
+                        new_bucket.nodes = map_huge_pages(size);
+                    new_bucket.huge_pages = new_bucket.nodes != nullptr;
+                    if (!new_bucket.huge_pages)
+                        new_bucket.nodes = node_allocator_traits::allocate(allocator, size);
+                    try {
+                        new_bucket.occupied = std::allocator_traits<rebind_allocator<std::uint64_t>>::allocate(bitmap_allocator, (size + BITS_PER_WORD - 1) / BITS_PER_WORD);
+                        if (bucket_index == buckets.size())
+                            buckets.push_back(new_bucket);
+                        else
+                            buckets[bucket_index] = new_bucket;
+                    }
+                    catch (...) {
+                        if (new_bucket.huge_pages)
+                            unmap_huge_pages(new_bucket.nodes, size);
+                        else
+                            node_allocator_traits::deallocate(allocator, new_bucket.nodes, size);
+                        throw;
+                    }
+                    insert_bucket_address(bucket_index);
+                    m_storage->compaction = {};
+                    return bucket_index;
+                }
+
+                // Returns a bucket whose nodes can be modified, copying them first if they are shared with snapshots.
+                bucket& writable_bucket(size_t bucket_index) {
+                    auto& bucket = m_storage->buckets[bucket_index];
+                    if constexpr (INDEX_LINKS) {
+                        if (bucket.frozen != nullptr) [[unlikely]]
+                            thaw(bucket_index);
+                    }
+                    return bucket;
+                }
+
+                // Stops sharing the nodes of a bucket with snapshots. If a snapshot still uses them, the bucket gets a copy of its nodes,
+                // which invalidates references to its elements. If copy_nodes is false, the bucket gets untouched nodes instead, so its elements are lost.
+                void thaw(size_t bucket_index, bool copy_nodes = true) {
+                    auto& bucket = m_storage->buckets[bucket_index];
+                    auto frozen = bucket.frozen;
+                    bucket.frozen = nullptr;
+                    if (frozen->nb_owners.load(std::memory_order_acquire) == 1) {
+                        // Every snapshot is gone, so the nodes belong to the bucket again.
+                        release_frozen_record(frozen, m_allocator);
+                        return;
+                    }
+                    if constexpr (std::is_copy_constructible_v<T>) {
+                        rebind_allocator<node> allocator(m_allocator);
+                        auto nodes = bucket.huge_pages ? map_huge_pages(bucket.size) : nullptr;
+                        bool huge_pages = nodes != nullptr;
+                        if (!huge_pages)
+                            nodes = node_allocator_traits::allocate(allocator, bucket.size);
+                        size_t i = 0;
+                        try {
+                            for (; copy_nodes && i < bucket.initialized; i++) {
+                                auto& src = frozen->nodes[i];
+                                auto& dst = *std::construct_at(nodes + i);
+                                if (!src.is_hole())
+                                    construct_element(dst, src.elem);
+                                dst.next = src.next;
+                                dst.prev_and_flag = src.prev_and_flag;
+                            }
+                        }
+                        catch (...) {
+                            while (i-- > 0) {
+                                if (!nodes[i].is_hole())
+                                    destroy_element(nodes[i]);
+                            }
+                            if (huge_pages)
+                                unmap_huge_pages(nodes, bucket.size);
+                            else
+                                node_allocator_traits::deallocate(allocator, nodes, bucket.size);
+                            bucket.frozen = frozen;
+                            throw;
+                        }
+                        bucket.nodes = nodes;
+                        bucket.huge_pages = huge_pages;
+                        if (!copy_nodes) {
+                            bucket.initialized = 0;
+                            bucket.nb_occupied = 0;
+                            bucket.first_free = 0;
+                        }
+                    }
+                    else {
+                        assert(false);  // Snapshots require copyable elements.
+                    }
+                    release_frozen(frozen, m_allocator);
+                }
+
+                // Copies every bucket shared with snapshots. This is needed before scanning the buckets to modify their nodes.
+                void thaw_all() {
+                    if constexpr (INDEX_LINKS) {
+                        if (m_storage == nullptr)
+                            return;
+                        for (size_t bucket_index = 1; bucket_index < m_storage->buckets.size(); bucket_index++) {
+                            if (m_storage->buckets[bucket_index].frozen != nullptr)
+                                thaw(bucket_index);
+                        }
+                    }
+                }
+
+                // Gives up one owner of frozen nodes. The last owner destroys the elements they still hold and frees them.
+                static void release_frozen(frozen_nodes* frozen, const Allocator& allocator) {
+                    if (frozen->nb_owners.fetch_sub(1, std::memory_order_acq_rel) != 1)
+                        return;
+                    Allocator element_allocator(allocator);
+                    for (size_t i = 0; i < frozen->initialized; i++) {
+                        if (!frozen->nodes[i].is_hole())
+                            allocator_traits::destroy(element_allocator, std::addressof(frozen->nodes[i].elem));
+                    }
+                    if (frozen->huge_pages) {
+                        unmap_huge_pages(frozen->nodes, frozen->size);
+                    }
+                    else {
+                        rebind_allocator<node> node_allocator(allocator);
+                        node_allocator_traits::deallocate(node_allocator, frozen->nodes, frozen->size);
+                    }
+                    release_frozen_record(frozen, allocator);
+                }
+
+                // Frees the record of frozen nodes, but not the nodes themselves.
+                static void release_frozen_record(frozen_nodes* frozen, const Allocator& allocator) {
+                    rebind_allocator<frozen_nodes> frozen_allocator(allocator);
+                    std::allocator_traits<rebind_allocator<frozen_nodes>>::destroy(frozen_allocator, frozen);
+                    std::allocator_traits<rebind_allocator<frozen_nodes>>::deallocate(frozen_allocator, frozen, 1);
+                }
+
+                // Maps nodes on huge pages, aligned on HUGE_PAGE_SIZE so that the kernel can back them with huge pages.
+                // Explicit huge pages (MAP_HUGETLB) are used if the system has some reserved, otherwise transparent huge pages are requested with madvise().
+                // Returns nullptr if the memory could not be mapped, or outside of Linux.
+                static node* map_huge_pages(size_t size) {
+#if defined(__linux__)
+                    size_t nb_bytes = huge_pages_length(size);
+#if defined(MAP_HUGETLB)
+                    void* nodes = mmap(nullptr, nb_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+                    if (nodes != MAP_FAILED)
+                        return static_cast<node*>(nodes);
+#endif
+                    // Map one more huge page than needed, then unmap what lies outside of the aligned range.
+                    void* mapping = mmap(nullptr, nb_bytes + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                    if (mapping == MAP_FAILED)
+                        return nullptr;
+                    auto first = reinterpret_cast<std::uintptr_t>(mapping);
+                    auto aligned = (first + HUGE_PAGE_SIZE - 1) & ~std::uintptr_t(HUGE_PAGE_SIZE - 1);
+                    if (aligned != first)
+                        munmap(mapping, aligned - first);
+                    munmap(reinterpret_cast<void*>(aligned + nb_bytes), first + HUGE_PAGE_SIZE - aligned);
+#if defined(MADV_HUGEPAGE)
+                    madvise(reinterpret_cast<void*>(aligned), nb_bytes, MADV_HUGEPAGE);
+#endif
+                    return reinterpret_cast<node*>(aligned);
+#else
+                    (void)size;
+                    return nullptr;
+#endif
+                }
+
+                // Unmaps nodes mapped by map_huge_pages().
+                static void unmap_huge_pages(node* nodes, size_t size) {
+#if defined(__linux__)
+                    munmap(nodes, huge_pages_length(size));
+#else
+                    (void)nodes;
+                    (void)size;
+#endif
+                }
+
+                // Length of the mapping of a bucket on huge pages, which is a whole number of huge pages.
+                static size_t huge_pages_length(size_t size) { return (size * sizeof(node) + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1); }
+
+                // Frees a bucket which holds no element. Its holes are removed from the hole list and its slot stays empty until reused.
+                void release_bucket(size_t bucket_index) {
+                    auto& storage = *m_storage;
+                    auto& bucket = storage.buckets[bucket_index];
+                    assert(bucket.nb_occupied == 0);
+                    for (size_t elem_index = 0; elem_index < bucket.initialized; elem_index++)
+                        unlink_hole(make_link(bucket_index, elem_index));
+                    storage.capacity -= bucket.size;
+                    deallocate_bucket(bucket);
+                    index_bucket_addresses();
+                    if (storage.frontier == bucket_index)
+                        storage.frontier = find_frontier();
+                    storage.compaction = {};
+                }
+
+                // Frees the buckets whose last element was just erased, if enough free nodes remain.
+                void auto_release_buckets() {
+                    auto& storage = *m_storage;
+                    for (size_t bucket_index = 1; bucket_index < storage.buckets.size(); bucket_index++) {
+                        auto& bucket = storage.buckets[bucket_index];
+                        if (bucket.nodes != nullptr && bucket.nb_occupied == 0 && bucket.initialized > 0 && storage.capacity - storage.size - bucket.size >= storage.auto_release_min_free)
+                            release_bucket(bucket_index);
+                    }
+                }
+
+                // Frees a bucket. Its elements must already have been destroyed, unless its nodes are shared with snapshots.
+                void deallocate_bucket(bucket& bucket) {
+                    if (bucket.nodes != nullptr) {
+                        rebind_allocator<node> allocator(m_storage->buckets.get_allocator());
+                        rebind_allocator<std::uint64_t> bitmap_allocator(m_storage->buckets.get_allocator());
+                        if (bucket.frozen != nullptr)
+                            release_frozen(bucket.frozen, m_allocator);
+                        else if (bucket.huge_pages)
+                            unmap_huge_pages(bucket.nodes, bucket.size);
+                        else
+                            node_allocator_traits::deallocate(allocator, bucket.nodes, bucket.size);
+                        std::allocator_traits<rebind_allocator<std::uint64_t>>::deallocate(bitmap_allocator, bucket.occupied, (bucket.size + BITS_PER_WORD - 1) / BITS_PER_WORD);
+                    }
+                    bucket = {};
+                }
+
+                // Constructs and destroys elements through the allocator.
+                template<class... Ts>
+                void construct_element(node& n, Ts&&... args) { allocator_traits::construct(m_allocator, std::addressof(n.elem), std::forward<Ts>(args)...); }
+                void destroy_element(node& n) { allocator_traits::destroy(m_allocator, std::addressof(n.elem)); }
+
+                // Takes other's elements by relinking the sentinels. This list must be empty and both lists must use the same storage.
+                void take_elements(vec_list& other) {
+                    assert(other.empty() || (empty() && m_storage == other.m_storage));
+                    if (other.empty())
+                        return;
+                    if constexpr (INDEX_LINKS) {
+                        // Links to the sentinel don't depend on its address, so only the sentinels change. This never copies buckets shared with snapshots.
+                        m_sentinel.next = std::exchange(other.m_sentinel.next, SENTINEL_LINK);
+                        m_sentinel.set_prev(other.m_sentinel.prev());
+                        other.m_sentinel.set_prev(SENTINEL_LINK);
+                    }
+                    else {
+                        link_two_nodes(end_link(), other.m_sentinel.next);
+                        link_two_nodes(other.m_sentinel.prev(), end_link());
+                        other.link_two_nodes(other.end_link(), other.end_link());
+                    }
+                    m_size = std::exchange(other.m_size, 0);
+                }
+
+                // Finds the bucket with the most untouched nodes, so that the larger ones are used first. Returns 0 if there are none.
+                size_t find_frontier() const {
+                    auto& buckets = m_storage->buckets;
+                    size_t frontier = 0;
+                    size_t max_untouched = 0;
+                    for (size_t bucket_index = 1; bucket_index < buckets.size(); bucket_index++) {
+                        size_t untouched = buckets[bucket_index].size - buckets[bucket_index].initialized;
+                        if (untouched > max_untouched) {
+                            frontier = bucket_index;
+                            max_untouched = untouched;
+                        }
+                    }
+                    return frontier;
+                }
+
+                // Appends count elements with the nodes linked in memory order in a single pass, without going through the hole list.
+                // The untouched nodes of the existing buckets are used first, then new buckets of exactly the right size are added.
+                // Holes are never reused, so this is meant for storages without holes, such as right after clear() on an unshared storage.
+                // construct(n, i) constructs the i-th element in the node n. If it throws, the elements constructed so far stay in the list.
+                template<class F>
+                void append_sequential(size_t count, F&& construct) {
+                    if (count == 0)
+                        return;
+                    auto& storage = get_storage();
+                    if (storage.size + count > max_size())
+                        throw std::length_error("vec_list is too large.");
+                    auto prev = at(end_link()).prev();
+                    size_t nb_constructed = 0;
+                    try {
+                        while (nb_constructed < count) {
+                            // Take the bucket with the most untouched nodes, or add one.
+                            size_t bucket_index = storage.frontier;
+                            if (bucket_index == 0) {
+                                if (storage.buckets.size() == MAX_BUCKETS && find_released_bucket() == MAX_BUCKETS)
+                                    throw std::length_error("vec_list has too many buckets.");
+                                size_t bucket_size = std::min(count - nb_constructed, MAX_BUCKET_SIZE);
+                                bucket_index = add_bucket(bucket_size);
+                                storage.capacity += bucket_size;
+                            }
+
+                            // Fill its untouched nodes in order.
+                            auto& bucket = storage.buckets[bucket_index];
+                            bool no_free_before = bucket.first_free == bucket.initialized;
+                            for (; bucket.initialized < bucket.size && nb_constructed < count; bucket.initialized++, nb_constructed++) {
+                                touch_node(bucket_index);
+                                auto l = make_link(bucket_index, bucket.initialized);
+                                construct(at(l), nb_constructed);
+                                bucket.occupied[bucket.initialized / BITS_PER_WORD] |= std::uint64_t(1) << (bucket.initialized % BITS_PER_WORD);
+                                bucket.nb_occupied++;
+                                link_two_nodes(prev, l);
+                                prev = l;
+                                m_size++;
+                                storage.size++;
+                            }
+                            if (no_free_before)
+                                bucket.first_free = bucket.initialized;
+                            storage.frontier = find_frontier();
+                        }
+                    }
+                    catch (...) {
+                        // The node being constructed stays untouched.
+                        link_two_nodes(prev, end_link());
+                        storage.frontier = find_frontier();
+                        throw;
+                    }
+                    link_two_nodes(prev, end_link());
+                }
+
+                // Resizes to fit at least nb_holes new elements.
+                // At the end of this function, there should be at least one hole or untouched node.
+                void resize_to_fit(std::int64_t nb_new_elements, bool is_reserve = false) {
+                    if (nb_new_elements <= 0)
+                        return;
+                    auto& storage = get_storage();
+                    auto capacity_required = storage.size + nb_new_elements;
+                    if (capacity_required <= storage.capacity)
+                        return;
+                    if (capacity_required > max_size())
+                        throw std::length_error("vec_list is too large.");
+
+                    // The new bucket should be either the minimum size or enough to fit all the required elements, whichever is larger.
+                    size_t bucket_size = std::max(MIN_BUCKET_SIZE, capacity_required - storage.capacity);
+
+                    // Unless this is reserve(), we should also respect the growth factor.
+                    if (!is_reserve)
+                        bucket_size = std::max(bucket_size, (size_t)std::ceil(storage.capacity * (GROWTH_FACTOR - 1)));
+
+                    // Add the bucket. Index links cannot address more than MAX_BUCKET_SIZE elements per bucket, so this might need more than one.
+                    do {
+                        if (storage.buckets.size() == MAX_BUCKETS && find_released_bucket() == MAX_BUCKETS)
+                            throw std::length_error("vec_list has too many buckets.");
+                        size_t current_bucket_size = std::min(bucket_size, MAX_BUCKET_SIZE);
+                        bucket_size -= current_bucket_size;
+                        add_bucket(current_bucket_size);
+                        storage.capacity += current_bucket_size;
+                    } while (storage.capacity < capacity_required);
+                    if (storage.frontier == 0)
+                        storage.frontier = find_frontier();
+                    assert(storage.first_hole != NULL_LINK || storage.frontier != 0);
+                }
+
+                // Utility function which links prev and next.
+                void link_two_nodes(link prev, link next) {
+                    if (next != NULL_LINK) at(next).set_prev(prev);
+                    if (prev != NULL_LINK) at(prev).next = next;
+                }
+
+                // Destroys every element without touching the links. Unless other lists have elements in the storage, only the occupied nodes are visited in memory order.
+                void destroy_elements() {
+                    if constexpr (!std::is_trivially_destructible_v<T> || requires (Allocator allocator) { allocator.destroy(std::addressof(at(NULL_LINK).elem)); }) {
+                        for_each_node_unordered([&](node& n) { destroy_element(n); });
+                    }
+                }
+
+                // Links the nodes between the sentinel in the order of the range.
+                template<class R>
+                void link_in_order(const R& links) {
+                    auto prev = end_link();
+                    for (auto current : links) {
+                        link_two_nodes(prev, current);
+                        prev = current;
+                    }
+                    link_two_nodes(prev, end_link());
+                }
+
+#if defined(PALLA_VEC_LIST_PARALLEL)
+                // Calls f(i) for every i in [0, n), each on its own thread, and rethrows the first exception once they are all done.
+                template<class F>
+                static void run_in_parallel(size_t n, F&& f) {
+                    std::vector<std::exception_ptr> exceptions(n);
+                    auto run = [&](size_t i) {
+                        try { f(i); }
+                        catch (...) { exceptions[i] = std::current_exception(); }
+                    };
+                    {
+                        std::vector<std::jthread> threads;
+                        threads.reserve(n);
+                        for (size_t i = 1; i < n; i++)
+                            threads.emplace_back(run, i);
+                        run(0);
+                    }
+                    for (auto& exception : exceptions) {
+                        if (exception)
+                            std::rethrow_exception(exception);
+                    }
+                }
+#endif
+
+                // Erased nodes which are added to the hole list all at once.
+                struct hole_chain {
+                    link first = NULL_LINK;
+                    link last = NULL_LINK;
+                    size_t size = 0;
+                    bool empties_bucket = false;    // Whether a bucket has no element left.
+                };
+
+                // Destroys an element, unlinks it and adds it to the chain. The hole list and the sizes are only updated by recycle_holes().
+                void erase_into(hole_chain& chain, link l) {
+                    auto& n = at(l);
+                    destroy_element(n);
+                    n.set_hole(true);
+                    chain.empties_bucket |= m_storage->buckets[set_occupied(l, false)].nb_occupied == 0;
+                    link_two_nodes(n.prev(), n.next);
+                    link_two_nodes(chain.last, l);
+                    if (chain.first == NULL_LINK)
+                        chain.first = l;
+                    chain.last = l;
+                    chain.size++;
+                }
+
+                // Adds a chain of erased nodes in front of the hole list. Returns the number of erased elements.
+                size_t recycle_holes(const hole_chain& chain) {
+                    if (chain.size == 0)
+                        return 0;
+                    auto& storage = *m_storage;
+                    link_two_nodes(chain.last, storage.first_hole);
+                    storage.first_hole = chain.first;
+                    if (storage.last_hole == NULL_LINK)
+                        storage.last_hole = chain.last;
+                    m_size -= chain.size;
+                    storage.size -= chain.size;
+                    if (storage.auto_release && chain.empties_bucket)
+                        auto_release_buckets();
+                    return chain.size;
+                }
+
+                // Returns the indices of the buckets sorted in descending order of size, which is the order optimize() fills them in.
+                // This is done through indices since the buckets cannot be reordered while index links refer to them.
+                rebind_vector<size_t> buckets_by_size() const {
+                    auto& buckets = m_storage->buckets;
+                    rebind_vector<size_t> bucket_order(buckets.size() - 1, m_allocator);
+                    std::iota(bucket_order.begin(), bucket_order.end(), 1);
+                    std::stable_sort(bucket_order.begin(), bucket_order.end(), [&](size_t a, size_t b) { return buckets[a].size > buckets[b].size; });
+                    return bucket_order;
+                }
+
+                // Removes a hole from anywhere in the hole list. Every hole but the first one has its previous hole as prev.
+                void unlink_hole(link l) {
+                    auto& storage = *m_storage;
+                    auto next = at(l).next;
+                    if (l == storage.first_hole) {
+                        // The prev of the first hole is never read, so the next hole does not need to be touched.
+                        storage.first_hole = next;
+                        if (next == NULL_LINK)
+                            storage.last_hole = NULL_LINK;
+                        return;
+                    }
+                    auto prev = at(l).prev();
+                    if (next == NULL_LINK)
+                        storage.last_hole = prev;
+                    link_two_nodes(prev, next);
+                }
+
+                // A free node for an insertion. It is either in the hole list, or the first untouched node of untouched_bucket.
+                struct free_node {
+                    link l = NULL_LINK;
+                    size_t untouched_bucket = 0;
+                };
+
+                // Chooses the free node for an insertion before pos according to the hole policy. There must be at least one free node.
+                free_node find_free_node(link pos) {
+                    auto& storage = *m_storage;
+                    if (storage.policy == hole_policy::lowest_address)
+                        return find_lowest_free_node();
+                    if (storage.policy == hole_policy::nearest) {
+                        // Look around the element which will precede the new one, or the one which will follow it at the front of the list.
+                        auto neighbor = at(pos).prev() != end_link() ? at(pos).prev() : pos;
+                        if (neighbor != end_link()) {
+                            auto nearest = find_free_node_near(neighbor);
+                            if (nearest.l != NULL_LINK)
+                                return nearest;
+                        }
+                    }
+                    if (storage.first_hole != NULL_LINK)
+                        return { storage.first_hole, 0 };
+                    return { make_link(storage.frontier, storage.buckets[storage.frontier].initialized), storage.frontier };
+                }
+
+                // Finds the first free node of the first bucket which is not full. Each bucket remembers where its first free node could be, so full words are only scanned once between erasures.
+                free_node find_lowest_free_node() {
+                    auto& buckets = m_storage->buckets;
+                    for (size_t bucket_index = 1; bucket_index < buckets.size(); bucket_index++) {
+                        auto& bucket = buckets[bucket_index];
+                        if (bucket.nb_occupied == bucket.size)
+                            continue;
+                        size_t elem_index = std::min(bucket.first_free, bucket.initialized);
+                        if (elem_index < bucket.initialized) {
+                            size_t word = elem_index / BITS_PER_WORD;
+                            auto bits = ~bucket.occupied[word] & (~std::uint64_t(0) << (elem_index % BITS_PER_WORD));
+                            while (bits == 0 && ++word < nb_bitmap_words(bucket))
+                                bits = ~bucket.occupied[word];
+                            elem_index = bits == 0 ? bucket.initialized : std::min(word * BITS_PER_WORD + std::countr_zero(bits), bucket.initialized);
+                        }
+                        bucket.first_free = elem_index;
+                        return { make_link(bucket_index, elem_index), elem_index == bucket.initialized ? bucket_index : 0 };
+                    }
+                    assert(false);
+                    return {};
+                }
+
+                // Finds the free node closest to an element within the same word of the bitmap, preferring the following nodes. Returns NULL_LINK if there are none.
+                free_node find_free_node_near(link l) const {
+                    auto [bucket_index, elem_index] = locate(l);
+                    auto& bucket = m_storage->buckets[bucket_index];
+                    size_t word = elem_index / BITS_PER_WORD;
+                    size_t bit = elem_index % BITS_PER_WORD;
+                    size_t first = word * BITS_PER_WORD;
+
+                    // Initialized nodes are free if their bit is not set, and so is the first untouched node. The bits past it are always 0.
+                    auto free_bits = ~bucket.occupied[word];
+                    size_t nb_usable = std::min(bucket.size, bucket.initialized + 1) - first;
+                    if (nb_usable < BITS_PER_WORD)
+                        free_bits &= (std::uint64_t(1) << nb_usable) - 1;
+                    auto after = bit + 1 < BITS_PER_WORD ? free_bits & (~std::uint64_t(0) << (bit + 1)) : 0;
+                    auto before = free_bits & ((std::uint64_t(1) << bit) - 1);
+                    if (after == 0 && before == 0)
+                        return {};
+                    size_t after_index = after != 0 ? first + std::countr_zero(after) : SIZE_MAX;
+                    size_t before_index = before != 0 ? first + BITS_PER_WORD - 1 - std::countl_zero(before) : 0;
+                    size_t index = after != 0 && (before == 0 || after_index - elem_index <= elem_index - before_index) ? after_index : before_index;
+                    return { make_link(bucket_index, index), index == bucket.initialized ? bucket_index : 0 };
+                }
+
+                // Adds a hole at the end of the hole list, so that it is reused last.
+                void append_hole(link l) {
+                    auto& storage = *m_storage;
+                    at(l).next = NULL_LINK;
+                    link_two_nodes(storage.last_hole, l);
+                    if (storage.first_hole == NULL_LINK)
+                        storage.first_hole = l;
+                    storage.last_hole = l;
+                }
+
+                // Finds the first hole at or after low and before target, in the order of the buckets.
+                // Each word of a bitmap consumes one unit of the budget. Returns SIZE_MAX if there are none or the budget runs out, with low updated to resume the search.
+                size_t find_hole_to_fill(const rebind_vector<size_t>& bucket_order, size_t& low, size_t target, size_t& budget) const {
+                    auto& buckets = m_storage->buckets;
+                    size_t start = 0;
+                    for (auto bucket_index : bucket_order) {
+                        auto& bucket = buckets[bucket_index];
+                        if (start >= target)
+                            break;
+                        size_t limit = std::min(bucket.size, target - start);
+                        if (low < start + limit) {
+                            size_t elem_index = std::max(low, start) - start;
+                            size_t end = std::min(limit, bucket.initialized);
+                            while (elem_index < end) {
+                                if (budget == 0) {
+                                    low = start + elem_index;
+                                    return SIZE_MAX;
+                                }
+                                budget--;
+                                size_t word = elem_index / BITS_PER_WORD;
+                                auto bits = ~bucket.occupied[word] & (~std::uint64_t(0) << (elem_index % BITS_PER_WORD));
+                                if (bits != 0 && word * BITS_PER_WORD + std::countr_zero(bits) < end)
+                                    return low = start + word * BITS_PER_WORD + std::countr_zero(bits);
+                                elem_index = (word + 1) * BITS_PER_WORD;
+                            }
+                            // Untouched nodes are holes too, but they must be used in order.
+                            if (bucket.initialized < limit)
+                                return low = start + bucket.initialized;
+                        }
+                        start += bucket.size;
+                        low = std::max(low, start);
+                    }
+                    return SIZE_MAX;
+                }
+
+                // Finds the last element before high and at or after target, in the order of the buckets.
+                // Each word of a bitmap consumes one unit of the budget. Returns SIZE_MAX if there are none or the budget runs out, with high updated to resume the search.
+                size_t find_element_to_move(const rebind_vector<size_t>& bucket_order, size_t& high, size_t target, size_t& budget) const {
+                    auto& buckets = m_storage->buckets;
+                    size_t end = std::accumulate(bucket_order.begin(), bucket_order.end(), size_t(0), [&](size_t sum, size_t bucket_index) { return sum + buckets[bucket_index].size; });
+                    for (auto it = bucket_order.rbegin(); it != bucket_order.rend(); ++it) {
+                        auto& bucket = buckets[*it];
+                        size_t start = end - bucket.size;
+                        if (end <= target)
+                            break;
+                        if (high > start) {
+                            size_t lower = std::max(target, start) - start;
+                            size_t elem_index = std::min(high - start, bucket.initialized);
+                            while (elem_index > lower) {
+                                if (budget == 0) {
+                                    high = start + elem_index;
+                                    return SIZE_MAX;
+                                }
+                                budget--;
+                                size_t word = (elem_index - 1) / BITS_PER_WORD;
+                                size_t nb_bits = elem_index - word * BITS_PER_WORD;
+                                auto bits = bucket.occupied[word] & (nb_bits == BITS_PER_WORD ? ~std::uint64_t(0) : (std::uint64_t(1) << nb_bits) - 1);
+                                if (bits != 0 && word * BITS_PER_WORD + BITS_PER_WORD - 1 - std::countl_zero(bits) >= lower)
+                                    return high = start + word * BITS_PER_WORD + BITS_PER_WORD - 1 - std::countl_zero(bits);
+                                elem_index = word * BITS_PER_WORD;
+                            }
+                        }
+                        end = start;
+                        high = std::min(high, end);
+                    }
+                    return SIZE_MAX;
+                }
+
+                // Moves [first, last) from other to before pos without moving any element. Both lists must share the same storage.
+                void transfer(link pos, vec_list& other, link first, link last, size_t count) {
+                    assert(m_storage == other.m_storage);
+                    if (first == last || (this == &other && (pos == first || pos == last)))
+                        return;
+                    auto before_first = other.at(first).prev();
+                    auto last_elem = other.at(last).prev();
+                    other.link_two_nodes(before_first, last);
+                    auto before_pos = at(pos).prev();
+                    link_two_nodes(before_pos, first);
+                    link_two_nodes(last_elem, pos);
+                    other.m_size -= count;
+                    m_size += count;
+                }
+
+            public:
+                // Public types.
+                using value_type = T;
+                using size_type = size_t;
+                using reference = T&;
+                using const_reference = const T&;
+                using iterator = iterator_impl<T>;
+                using const_iterator = iterator_impl<const T>;
+                using reverse_iterator = std::reverse_iterator<iterator_impl<T>>;
+                using const_reverse_iterator = std::reverse_iterator<iterator_impl<const T>>;
+                using allocator_type = Allocator;
+                using pool_type = vec_list_pool<T, Links, Allocator>;
+                using unordered_iterator = unordered_iterator_impl<T>;
+                using const_unordered_iterator = unordered_iterator_impl<const T>;
+
+                // Statistics about the memory layout, to decide when to call optimize().
+                struct stats_type {
+                    struct bucket_stats {
+                        size_t capacity = 0;        // Number of nodes.
+                        size_t nb_elements = 0;     // Number of nodes holding an element, of this list or of other lists sharing the storage.
+                        size_t nb_untouched = 0;    // Number of nodes which have never been used.
+                    };
+                    rebind_vector<bucket_stats> buckets;    // In order of their index, including buckets shared with other lists but not released ones.
+                    size_t nb_holes = 0;                    // Free nodes of the storage, including untouched ones.
+                    size_t hole_list_length = 0;            // Free nodes which have been used before. They are reused before untouched nodes.
+                    double locality = 1;                    // Fraction of the elements (except the last) whose next element is the adjacent node in memory.
+                };
+
+
+                // A read-only view of the list at the time snapshot() was called. It shares the buckets of the list, which copies a bucket
+                // the first time it modifies it afterwards. The snapshot only reads nodes which the list no longer modifies,
+                // so it can be read and destroyed on another thread while the list keeps being modified. It may outlive the list.
+                class snapshot_type {
+                private:
+                    friend class vec_list;
+
+                    // Iterators resolve links through the buckets of the snapshot, like index links are resolved through the list.
+                    class const_iterator_impl {
+                    private:
+                        friend class snapshot_type;
+                        explicit const_iterator_impl(link link, const snapshot_type* snapshot) : m_link(link), m_snapshot(snapshot) {}
+
+                        const node& get() const { return m_snapshot->at(m_link); }
+
+                        link m_link = NULL_LINK;
+                        const snapshot_type* m_snapshot = nullptr;
+
+                    public:
+                        // Types required to satisfy std::bidirectional_iterator.
+                        using difference_type = std::ptrdiff_t;
+                        using value_type = T;
+
+                        const_iterator_impl() = default;
+
+                        // Indirection.
+                        const T& operator*() const { return get().elem; }
+                        const T* operator->() const { return &**this; }
+
+                        // Increment and decrement.
+                        const_iterator_impl& operator++() { m_link = get().next; return *this; }
+                        const_iterator_impl operator++(int) { const_iterator_impl current = *this; ++(*this); return current; }
+
+                        const_iterator_impl& operator--() { m_link = get().prev(); return *this; }
+                        const_iterator_impl operator--(int) { const_iterator_impl current = *this; --(*this); return current; }
+
+                        // Comparison.
+                        friend bool operator==(const const_iterator_impl& a, const const_iterator_impl& b) { return a.m_link == b.m_link; }
+                    };
+
+                    explicit snapshot_type(const Allocator& allocator) : m_buckets(allocator), m_allocator(allocator) {}
+
+                    const node& at(link l) const { return l == SENTINEL_LINK ? m_sentinel : m_buckets[l >> OFFSET_BITS]->nodes[l & OFFSET_MASK]; }
+
+                    void copy_sentinel(const node& sentinel) {
+                        m_sentinel.next = sentinel.next;
+                        m_sentinel.set_prev(sentinel.prev());
+                    }
+
+                    // Gives up every frozen bucket.
+                    void release() noexcept {
+                        for (auto frozen : m_buckets) {
+                            if (frozen != nullptr)
+                                release_frozen(frozen, m_allocator);
+                        }
+                        m_buckets.clear();
+                        m_size = 0;
+                        m_sentinel.next = SENTINEL_LINK;
+                        m_sentinel.set_prev(SENTINEL_LINK);
+                    }
+
+                    // Private members.
+                    node m_sentinel;                            // Links of the sentinel of the list.
+                    rebind_vector<frozen_nodes*> m_buckets;     // Nodes of each bucket of the list, or nullptr for the sentinel and released buckets.
+                    size_t m_size = 0;
+                    [[no_unique_address]] Allocator m_allocator;
+
+                public:
+                    // Public types.
+                    using value_type = T;
+                    using size_type = size_t;
+                    using const_reference = const T&;
+                    using const_iterator = const_iterator_impl;
+                    using iterator = const_iterator;
+                    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+                    using reverse_iterator = const_reverse_iterator;
+
+                    // Copies share the buckets. Moving invalidates the iterators of the moved-from snapshot, which becomes empty.
+                    snapshot_type(const snapshot_type& other) : m_buckets(other.m_buckets), m_size(other.m_size), m_allocator(other.m_allocator) {
+                        copy_sentinel(other.m_sentinel);
+                        for (auto frozen : m_buckets) {
+                            if (frozen != nullptr)
+                                frozen->nb_owners.fetch_add(1, std::memory_order_relaxed);
+                        }
+                    }
+                    snapshot_type(snapshot_type&& other) noexcept : m_buckets(std::move(other.m_buckets)), m_size(other.m_size), m_allocator(other.m_allocator) {
+                        copy_sentinel(other.m_sentinel);
+                        other.m_buckets.clear();
+                        other.release();
+                    }
+                    snapshot_type& operator=(snapshot_type other) noexcept {
+                        std::swap(m_buckets, other.m_buckets);
+                        std::swap(m_size, other.m_size);
+                        std::swap(m_allocator, other.m_allocator);
+                        node sentinel;
+                        sentinel.next = m_sentinel.next;
+                        sentinel.set_prev(m_sentinel.prev());
+                        copy_sentinel(other.m_sentinel);
+                        other.copy_sentinel(sentinel);
+                        return *this;
+                    }
+                    ~snapshot_type() { release(); }
+
+                    // Accessors.
+                    [[nodiscard]] bool empty() const { return m_size == 0; }
+                    [[nodiscard]] size_type size() const { return m_size; }
+                    [[nodiscard]] const_reference front() const { return *begin(); }
+                    [[nodiscard]] const_reference back() const { return *std::prev(end()); }
+
+                    // Iterators.
+                    [[nodiscard]] const_iterator begin() const { return const_iterator(m_sentinel.next, this); }
+                    [[nodiscard]] const_iterator end() const { return const_iterator(SENTINEL_LINK, this); }
+                    [[nodiscard]] const_iterator cbegin() const { return begin(); }
+                    [[nodiscard]] const_iterator cend() const { return end(); }
+                    [[nodiscard]] const_reverse_iterator rbegin() const { return std::make_reverse_iterator(end()); }
+                    [[nodiscard]] const_reverse_iterator rend() const { return std::make_reverse_iterator(begin()); }
+                    [[nodiscard]] const_reverse_iterator crbegin() const { return rbegin(); }
+                    [[nodiscard]] const_reverse_iterator crend() const { return rend(); }
+                };
+
+
+                // Public functions.
+
+                // Constructors.
+                // Empty lists don't allocate anything.
+                vec_list() noexcept(noexcept(Allocator())) : vec_list(Allocator()) {}
+                explicit vec_list(const Allocator& allocator) noexcept : m_allocator(allocator) { link_two_nodes(end_link(), end_link()); }
+
+                // Creates a list whose nodes come from the pool. Lists of the same pool can splice partial ranges without moving any element.
+                explicit vec_list(pool_type& pool) : m_allocator(pool.m_list.m_allocator), m_storage(pool.m_list.m_storage) {
+                    m_storage->nb_owners++;
+                    link_two_nodes(end_link(), end_link());
+                }
+
+                template<class it>
+                    requires std::input_iterator<it>
+                vec_list(it first, it last, const Allocator& allocator = Allocator()) : vec_list(allocator) { insert(begin(), first, last); }
+                vec_list(std::initializer_list<T> list, const Allocator& allocator = Allocator()) : vec_list(list.begin(), list.end(), allocator) {}
+
+                vec_list(size_t count, const T& value, const Allocator& allocator = Allocator()) : vec_list(allocator) { insert(begin(), count, value); }
+                explicit vec_list(size_t count, const Allocator& allocator = Allocator()) : vec_list(allocator) { for (size_t i = 0; i < count; i++) insert(begin(), T{}); }
+
+                // vec_list is always movable, even if T is not, unless the allocator does not propagate on move.
+                // Moving steals the storage, so other is left empty without any memory.
+                vec_list(vec_list&& other) noexcept : m_allocator(other.m_allocator), m_storage(other.m_storage) {
+                    link_two_nodes(end_link(), end_link());
+                    take_elements(other);
+                    other.m_storage = nullptr;
+                }
+                vec_list& operator=(vec_list&& other) noexcept(ALLOCATOR_PROPAGATES_ON_MOVE) requires (ALLOCATOR_PROPAGATES_ON_MOVE || std::movable<T>) {
+                    if (this == &other)
+                        return *this;
+                    clear();
+                    if constexpr (!ALLOCATOR_PROPAGATES_ON_MOVE) {
+                        // The buckets cannot change allocator, so the elements must be moved one by one.
+                        if (m_allocator != other.m_allocator) {
+                            insert(end(), std::make_move_iterator(other.begin()), std::make_move_iterator(other.end()));
+                            other.clear();
+                            return *this;
+                        }
+                    }
+                    release_storage();
+                    if constexpr (allocator_traits::propagate_on_container_move_assignment::value)
+                        m_allocator = other.m_allocator;
+                    m_storage = other.m_storage;
+                    take_elements(other);
+                    other.m_storage = nullptr;
+                    return *this;
+                }
+
+                ~vec_list() { clear(); release_storage(); }
+
+                // vec_list is copyable if T is.
+                vec_list(const vec_list& other) requires std::copyable<T> : vec_list(allocator_traits::select_on_container_copy_construction(other.get_allocator())) { *this = other; }
+                vec_list& operator=(const vec_list& other) requires std::copyable<T> {
+                    if (this == &other)
+                        return *this;
+                    if constexpr (ALLOCATOR_PROPAGATES_ON_COPY) {
+                        // Free everything with the current allocator before replacing it.
+                        if (m_allocator != other.m_allocator) {
+                            clear();
+                            release_storage();
+                        }
+                        m_allocator = other.m_allocator;
+                    }
+                    // Unless other lists share the storage, clear() leaves no holes, so the nodes can be written in list order with their links
+                    // in a single pass instead of one emplace() per element.
+                    this->clear();
+                    if (is_storage_shared())
+                        this->insert(this->begin(), other.begin(), other.end());
+                    else
+                        append_sequential(other.m_size, [&, it = other.begin()](node& n, size_t) mutable { construct_element(n, *it++); });
+                    return *this;
+                }
+
+                // Swaps two lists along with their storage. The allocators must either be equal or propagate on swap.
+                void swap(vec_list& other) noexcept {
+                    assert(ALLOCATOR_PROPAGATES_ON_SWAP || m_allocator == other.m_allocator);
+                    if constexpr (allocator_traits::propagate_on_container_swap::value)
+                        std::swap(m_allocator, other.m_allocator);
+                    std::swap(m_storage, other.m_storage);
+
+                    // The sentinels stay in place, so the first and last elements must be relinked to the other sentinel.
+                    auto first = m_sentinel.next, last = m_sentinel.prev();
+                    auto other_first = other.m_sentinel.next, other_last = other.m_sentinel.prev();
+                    link_two_nodes(end_link(), end_link());
+                    other.link_two_nodes(other.end_link(), other.end_link());
+                    if (other.m_size > 0) {
+                        link_two_nodes(end_link(), other_first);
+                        link_two_nodes(other_last, end_link());
+                    }
+                    if (m_size > 0) {
+                        other.link_two_nodes(other.end_link(), first);
+                        other.link_two_nodes(last, other.end_link());
+                    }
+                    std::swap(m_size, other.m_size);
+                }
+                friend void swap(vec_list& a, vec_list& b) noexcept { a.swap(b); }
+
+                [[nodiscard]] allocator_type get_allocator() const { return m_allocator; }
+
+                // The hole policy belongs to the storage, so it is shared by every list of a pool. Setting it creates the storage if needed.
+                [[nodiscard]] hole_policy get_hole_policy() const { return m_storage == nullptr ? hole_policy::most_recent : m_storage->policy; }
+                void set_hole_policy(hole_policy policy) { get_storage().policy = policy; }
+
+                // Whether new buckets of at least 2MB are mapped on huge pages instead of allocated through the allocator, which reduces TLB misses
+                // when following the links of a large list. This only has an effect on Linux. Like the hole policy, this belongs to the storage.
+                [[nodiscard]] bool get_huge_pages() const { return m_storage != nullptr && m_storage->huge_pages; }
+                void set_huge_pages(bool enabled) { get_storage().huge_pages = enabled; }
+
+                // Accessors.
+                [[nodiscard]] bool empty() const { return m_size == 0; }
+                [[nodiscard]] size_type size() const { return m_size; }
+                [[nodiscard]] size_type max_size() const {
+                    if constexpr (INDEX_LINKS)
+                        return (MAX_BUCKETS - 1) * MAX_BUCKET_SIZE;
+                    else
+                        return node_allocator_traits::max_size(rebind_allocator<node>(m_allocator));
+                }
+                // The capacity includes every hole of the storage, even if it is shared with other lists.
+                [[nodiscard]] size_type capacity() const { return m_storage == nullptr ? 0 : m_size + m_storage->capacity - m_storage->size; }
+
+                // Iterators.
+                [[nodiscard]] iterator begin() { return make_iterator(m_sentinel.next); }
+                [[nodiscard]] iterator end() { return make_iterator(end_link()); }
+                [[nodiscard]] const_iterator begin() const { return const_cast<vec_list*>(this)->begin(); }
+                [[nodiscard]] const_iterator end() const { return const_cast<vec_list*>(this)->end(); }
+                [[nodiscard]] const_iterator cbegin() const { return begin(); }
+                [[nodiscard]] const_iterator cend() const { return end(); }
+
+                [[nodiscard]] reverse_iterator rbegin() { return std::make_reverse_iterator(end()); }
+                [[nodiscard]] reverse_iterator rend() { return std::make_reverse_iterator(begin()); }
+                [[nodiscard]] const_reverse_iterator rbegin() const { return std::make_reverse_iterator(end()); }
+                [[nodiscard]] const_reverse_iterator rend() const { return std::make_reverse_iterator(begin()); }
+                [[nodiscard]] const_reverse_iterator crbegin() const { return std::make_reverse_iterator(end()); }
+                [[nodiscard]] const_reverse_iterator crend() const { return std::make_reverse_iterator(begin()); }
+
+                // Elements in memory order instead of list order. Scanning the buckets sequentially is much faster than following the links after a lot of insertions and erasures.
+                // Lists sharing their storage with other lists which also have elements fall back to list order.
+                // Inserting or erasing elements invalidates unordered iterators.
+                [[nodiscard]] std::ranges::subrange<unordered_iterator> unordered_view() { thaw_all(); return { make_unordered_begin(), unordered_iterator(this, &m_sentinel, 0) }; }
+                [[nodiscard]] std::ranges::subrange<const_unordered_iterator> unordered_view() const { return { make_unordered_begin(), const_unordered_iterator(this, &m_sentinel, 0) }; }
+
+                // Calls f on every element in memory order, with the same guarantees as unordered_view(). f must not insert or erase elements.
+                template<class F>
+                void for_each_unordered(F&& f) { thaw_all(); for_each_node_unordered([&](node& n) { f(n.elem); }); }
+                template<class F>
+                void for_each_unordered(F&& f) const { for_each_node_unordered([&](const node& n) { f(n.elem); }); }
+
+#if defined(PALLA_VEC_LIST_PARALLEL)
+                // Calls f on every element in memory order on multiple threads. f must be safe to call concurrently on different elements.
+                // The bitmaps of the buckets are split into chunks of about the same number of nodes, each scanned on its own thread.
+                // Small lists, policies other than par and par_unseq and lists sharing their storage with other lists which have elements simply call for_each_unordered(f).
+                template<class ExecutionPolicy, class F>
+                    requires std::is_execution_policy_v<std::remove_cvref_t<ExecutionPolicy>>
+                void for_each_unordered(ExecutionPolicy&&, F&& f) { thaw_all(); parallel_for_each_node_unordered<std::remove_cvref_t<ExecutionPolicy>>([&](node& n) { f(n.elem); }); }
+                template<class ExecutionPolicy, class F>
+                    requires std::is_execution_policy_v<std::remove_cvref_t<ExecutionPolicy>>
+                void for_each_unordered(ExecutionPolicy&&, F&& f) const { parallel_for_each_node_unordered<std::remove_cvref_t<ExecutionPolicy>>([&](const node& n) { f(n.elem); }); }
+#endif
+
+                // Front and back.
+                [[nodiscard]] reference front() { return *begin(); }
+                [[nodiscard]] const_reference front() const { return *begin(); }
+                [[nodiscard]] reference back() { return *std::prev(end()); }
+                [[nodiscard]] const_reference back() const { return *std::prev(end()); }
+
+                // Assign.
+                template<class it>
+                void assign(it first, it last) { clear(); insert(first, last); }
+                void assign(size_t count, const T& value) requires std::copyable<T> { clear(); insert(end(), count, value); }
+                void assign(std::initializer_list<T> list) requires std::copyable<T> { assign(list.begin(), list.end()); }
+
+                // Insert.
+                iterator insert(const_iterator pos, T&& value) requires std::movable<T> { return emplace(pos, std::move(value)); }
+                iterator insert(const_iterator pos, const T& value) requires std::copyable<T> { return emplace(pos, value); }
+                void insert(const_iterator pos, std::initializer_list<T> list) requires std::copyable<T> { insert(pos, list.begin(), list.end()); }
+
+                template<class it>
+                    requires std::input_iterator<it>
+                void insert(const_iterator pos, it first, it last) {
+                    if constexpr (std::forward_iterator<it>)
+                        resize_to_fit(std::distance(first, last));
+                    while (first != last)
+                        insert(pos, *(first++));
+                }
+
+                void insert(const_iterator pos, size_t count, const T& value) requires std::copyable<T> {
+                    resize_to_fit(count);
+                    for (size_t i = 0; i < count; i++)
+                        insert(pos, value);
+                }
+
+                // Push and pop.
+                template<class... Ts>
+                reference emplace_back(Ts&&... args) { return *emplace(end(), std::forward<Ts>(args)...); }
+                reference push_back(T&& value) requires std::movable<T> { return emplace_back(std::move(value)); }
+                reference push_back(const T& value) requires std::copyable<T> { return emplace_back(value); }
+                void pop_back() { erase(std::prev(end())); }
+
+                template<class... Ts>
+                reference emplace_front(Ts&&... args) { return *emplace(begin(), std::forward<Ts>(args)...); }
+                reference push_front(T&& value) requires std::movable<T> { return emplace_front(std::move(value)); }
+                reference push_front(const T& value) requires std::copyable<T> { return emplace_front(value); }
+                void pop_front() { erase(begin()); }
+
+                // Comparisons.
+                [[nodiscard]] friend bool operator==(const vec_list& a, const vec_list& b) {
+                    if (a.size() != b.size())
+                        return false;
+                    return std::equal(a.begin(), a.end(), b.begin(), b.end());
+                }
+
+                [[nodiscard]] friend auto operator<=>(const vec_list& a, const vec_list& b) {
+                    return std::lexicographical_compare_three_way(a.begin(), a.end(), b.begin(), b.end());
+                }
+
+                // Actual emplace function that does all the work.
+                template<class... Ts>
+                iterator emplace(const_iterator pos, Ts&&... args) {
+                    auto& storage = get_storage();
+
+                    // If there are no more holes, add a new bucket to create new ones.
+                    if (storage.first_hole == NULL_LINK && storage.frontier == 0)
+                        resize_to_fit(1);
+
+                    // Choose a free node according to the hole policy.
+                    auto [current, untouched_bucket] = find_free_node(pos.m_link);
+                    if (untouched_bucket != 0)
+                        touch_node(untouched_bucket);
+
+                    // Set the element. Do this before touching the holes in case the constructor throws.
+                    auto& current_node = at(current);
+                    construct_element(current_node, std::forward<Ts>(args)...);
+                    current_node.set_hole(false);
+                    if (untouched_bucket != 0)
+                        set_occupied(untouched_bucket, storage.buckets[untouched_bucket].initialized, true);    // No need to search for the bucket.
+                    else
+                        set_occupied(current, true);
+                    m_size++;
+                    storage.size++;
+
+                    if (untouched_bucket == 0) {
+                        // Fill the hole.
+                        unlink_hole(current);
+                    }
+                    else {
+                        // Move past the untouched node. If this was the frontier and it is now full, find another bucket with untouched nodes.
+                        auto& bucket = storage.buckets[untouched_bucket];
+                        if (++bucket.initialized == bucket.size && storage.frontier == untouched_bucket)
+                            storage.frontier = find_frontier();
+                    }
+
+                    // Link the element to pos.
+                    auto prev = at(pos.m_link).prev();
+                    link_two_nodes(current, pos.m_link);
+                    link_two_nodes(prev, current);
+                    return make_iterator(current);
+                }
+
+                // Actual erase function that does all the work.
+                iterator erase(const_iterator first, const_iterator last) { while (first != last) { first = erase(first); } return make_iterator(first.m_link); }
+                iterator erase(const_iterator it) {
+                    assert(it.m_link != NULL_LINK && it.m_link != end_link() && !at(it.m_link).is_hole());
+                    auto& storage = *m_storage;
+                    auto& it_node = at(it.m_link);
+
+                    // Erase the element.
+                    m_size--;
+                    storage.size--;
+                    destroy_element(it_node);
+                    it_node.set_hole(true);
+                    bool empties_bucket = storage.buckets[set_occupied(it.m_link, false)].nb_occupied == 0;
+
+                    // Link the neighbors together.
+                    auto next = it_node.next;
+                    link_two_nodes(it_node.prev(), it_node.next);
+                    link_two_nodes(it.m_link, storage.first_hole);
+
+                    // Make the element the first hole.
+                    storage.first_hole = it.m_link;
+                    if (storage.last_hole == NULL_LINK)
+                        storage.last_hole = storage.first_hole;
+
+                    if (storage.auto_release && empties_bucket)
+                        auto_release_buckets();
+                    return make_iterator(next);
+                }
+
+                // Clears the list. This is proportional to the number of elements, not the capacity, since the holes are simply forgotten
+                // and every bucket goes back to being untouched. The bitmaps are reset as the nodes are touched again.
+                void clear() {
+                    if (m_storage == nullptr)
+                        return;
+                    auto& storage = *m_storage;
+                    if (storage.size != m_size) {
+                        // Other lists have elements in the storage, so the nodes must become holes one by one.
+                        erase(begin(), end());
+                        return;
+                    }
+                    // Buckets shared with snapshots are replaced by untouched nodes instead of being copied.
+                    if constexpr (INDEX_LINKS) {
+                        for (size_t bucket_index = 1; bucket_index < storage.buckets.size(); bucket_index++) {
+                            if (storage.buckets[bucket_index].frozen != nullptr)
+                                thaw(bucket_index, false);
+                        }
+                    }
+                    destroy_elements();
+                    storage.first_hole = NULL_LINK;
+                    storage.last_hole = NULL_LINK;
+                    for (size_t bucket_index = 1; bucket_index < storage.buckets.size(); bucket_index++) {
+                        auto& bucket = storage.buckets[bucket_index];
+                        bucket.initialized = 0;
+                        bucket.nb_occupied = 0;
+                        bucket.first_free = 0;
+                    }
+                    storage.frontier = find_frontier();
+                    storage.size = 0;
+                    storage.compaction = {};
+                    link_two_nodes(end_link(), end_link());
+                    m_size = 0;
+                }
+
+                // Reserves more memory. Much like std::vector, this bypasses geometric growth and allocates only the required amount.
+                void reserve(size_t new_capacity) { resize_to_fit(new_capacity - capacity(), true); }
+
+                // Resizes up or down by adding or removing elements at the end.
+                void resize(size_t new_size) {
+                    while (m_size > new_size)
+                        pop_back();
+                    resize_to_fit(new_size - m_size);
+                    while (m_size < new_size)
+                        emplace_back();
+                }
+
+                void resize(size_t new_size, const T& value) requires std::copyable<T> {
+                    while (m_size > new_size)
+                        pop_back();
+                    insert(end(), new_size - m_size, value);
+                }
+
+                // Reverse the list.
+                void reverse() {
+                    // Reverse the elements and the sentinel. Holes can stay the same.
+                    auto current = end_link();
+                    do {
+                        auto& current_node = at(current);
+                        auto next = current_node.next;
+                        current_node.next = current_node.prev();
+                        current_node.set_prev(next);
+                        current = next;
+                    } while (current != end_link());
+                }
+
+                // Sorts the list by relinking the nodes, so iterators/references stay valid. The sort is stable.
+                // The links are gathered in an array and merge sorted there, which is much more cache-friendly than merging linked nodes.
+                // Call optimize() afterwards to also lay the elements out in sorted order.
+                template<class Compare = std::less<>>
+                void sort(Compare compare = Compare()) {
+                    if (m_size < 2)
+                        return;
+                    rebind_vector<link> links(m_allocator);
+                    links.reserve(m_size);
+                    for (auto current = m_sentinel.next, last = end_link(); current != last; current = at(current).next)
+                        links.push_back(current);
+                    std::stable_sort(links.begin(), links.end(), [&](link a, link b) { return compare(peek(a).elem, peek(b).elem); });
+                    link_in_order(links);
+                }
+
+#if defined(PALLA_VEC_LIST_PARALLEL)
+                // Sorts the list on multiple threads, with the same guarantees as sort(). Small lists and policies other than par and par_unseq simply call sort().
+                // Chunks of the array of links are sorted on their own thread, then adjacent chunks are merged in parallel rounds so the sort stays stable.
+                template<class ExecutionPolicy, class Compare = std::less<>>
+                    requires std::is_execution_policy_v<std::remove_cvref_t<ExecutionPolicy>>
+                void sort(ExecutionPolicy&&, Compare compare = Compare()) {
+                    size_t nb_chunks = std::min<size_t>(max_threads(), m_size / MIN_PARALLEL_CHUNK_SIZE);
+                    if (!IS_PARALLEL_POLICY<std::remove_cvref_t<ExecutionPolicy>> || nb_chunks < 2)
+                        return sort(compare);
+
+                    rebind_vector<link> links(m_allocator);
+                    links.reserve(m_size);
+                    for (auto current = m_sentinel.next, last = end_link(); current != last; current = at(current).next)
+                        links.push_back(current);
+                    auto less = [&](link a, link b) { return compare(peek(a).elem, peek(b).elem); };
+                    auto chunk_begin = [&](size_t chunk) { return links.begin() + std::min(chunk, nb_chunks) * m_size / nb_chunks; };
+
+                    run_in_parallel(nb_chunks, [&](size_t chunk) {
+                        std::stable_sort(chunk_begin(chunk), chunk_begin(chunk + 1), less);
+                    });
+                    for (size_t width = 1; width < nb_chunks; width *= 2) {
+                        run_in_parallel((nb_chunks + 2 * width - 1) / (2 * width), [&](size_t i) {
+                            size_t first = i * 2 * width;
+                            std::inplace_merge(chunk_begin(first), chunk_begin(first + width), chunk_begin(first + 2 * width), less);
+                        });
+                    }
+                    link_in_order(links);
+                }
+#endif
+
+                // Removes elements. The erased nodes are added to the hole list in a single batch.
+                size_type remove(const T& value) {
+                    // The value might be an element of this list, in which case it is erased last.
+                    hole_chain chain;
+                    link value_link = NULL_LINK;
+                    try {
+                        for (auto current = m_sentinel.next, last = end_link(); current != last;) {
+                            auto next = at(current).next;
+                            if (std::addressof(at(current).elem) == std::addressof(value))
+                                value_link = current;
+                            else if (at(current).elem == value)
+                                erase_into(chain, current);
+                            current = next;
+                        }
+                    }
+                    catch (...) {
+                        recycle_holes(chain);
+                        throw;
+                    }
+                    if (value_link != NULL_LINK)
+                        erase_into(chain, value_link);
+                    return recycle_holes(chain);
+                }
+
+                template<class Predicate>
+                size_type remove_if(Predicate pred) {
+                    hole_chain chain;
+                    try {
+                        for (auto current = m_sentinel.next, last = end_link(); current != last;) {
+                            auto next = at(current).next;
+                            if (pred(at(current).elem))
+                                erase_into(chain, current);
+                            current = next;
+                        }
+                    }
+                    catch (...) {
+                        recycle_holes(chain);
+                        throw;
+                    }
+                    return recycle_holes(chain);
+                }
+
+                // Removes consecutive duplicates, keeping the first one. The erased nodes are added to the hole list in a single batch.
+                template<class BinaryPredicate = std::equal_to<>>
+                size_type unique(BinaryPredicate pred = BinaryPredicate()) {
+                    if (m_size < 2)
+                        return 0;
+                    hole_chain chain;
+                    try {
+                        auto kept = m_sentinel.next;
+                        for (auto current = at(kept).next, last = end_link(); current != last;) {
+                            auto next = at(current).next;
+                            if (pred(at(kept).elem, at(current).elem))
+                                erase_into(chain, current);
+                            else
+                                kept = current;
+                            current = next;
+                        }
+                    }
+                    catch (...) {
+                        recycle_holes(chain);
+                        throw;
+                    }
+                    return recycle_holes(chain);
+                }
+
+                // Merges two sorted lists. Other's buckets are absorbed like splice() does, then the nodes are relinked in order.
+                // The merge is stable and elements are never moved unless splice() has to.
+                template<class Compare = std::less<>>
+                void merge(vec_list& other, Compare compare = Compare()) {
+                    if (this == &other || other.empty())
+                        return;
+
+                    // Splice other at the end. Remember the boundary through this list's last element since other's links might change.
+                    auto last_of_this = m_sentinel.prev();
+                    splice(end(), other);
+                    auto first1 = m_sentinel.next;
+                    auto first2 = at(last_of_this).next;
+
+                    // Move the elements of the second run before the first larger element of the first run.
+                    while (first1 != first2 && first2 != end_link()) {
+                        if (compare(at(first2).elem, at(first1).elem)) {
+                            auto next2 = at(first2).next;
+                            transfer(first1, *this, first2, next2, 0);
+                            first2 = next2;
+                        }
+                        else {
+                            first1 = at(first1).next;
+                        }
+                    }
+                }
+                template<class Compare = std::less<>>
+                void merge(vec_list&& other, Compare compare = Compare()) { merge(other, compare); }
+
+                // Splices two lists together.
+                void splice(const_iterator pos, vec_list& other) {
+                    assert(this != &other);
+                    if (other.empty())
+                        return;
+
+                    // A list without storage shares other's. Other gives it up unless it is also used by other lists, like a pool.
+                    if (m_storage == nullptr && m_allocator == other.m_allocator) {
+                        bool is_other_shared = other.is_storage_shared();
+                        m_storage = other.m_storage;
+                        m_storage->nb_owners++;
+                        transfer(pos.m_link, other, other.m_sentinel.next, other.end_link(), other.m_size);
+                        if (!is_other_shared)
+                            other.release_storage();
+                        return;
+                    }
+
+                    // Lists of the same pool only need to be relinked.
+                    if (m_storage == other.m_storage)
+                        return transfer(pos.m_link, other, other.m_sentinel.next, other.end_link(), other.m_size);
+
+                    // Buckets can only be exchanged between equal allocators, if other is the only list using them,
+                    // and index links cannot address more than MAX_BUCKETS buckets.
+                    // Otherwise fall back to moving the elements.
+                    auto& storage = get_storage();
+                    auto& other_storage = *other.m_storage;
+                    if (m_allocator != other.m_allocator || other.is_storage_shared() || storage.buckets.size() + other_storage.buckets.size() - 1 > MAX_BUCKETS) {
+                        if constexpr (std::movable<T>) {
+                            this->insert(pos, std::make_move_iterator(other.begin()), std::make_move_iterator(other.end()));
+                            other.clear();
+                            return;
+                        }
+                        else {
+                            throw std::length_error("vec_list has too many buckets.");
+                        }
+                    }
+                    reserve_bucket_addresses(nb_allocated_buckets() + other.nb_allocated_buckets());
+
+                    // Find the elements to link before other's buckets are moved.
+                    auto first = other.m_sentinel.next;
+                    auto last = other.m_sentinel.prev();
+
+                    // Index links contain the bucket index, so other's links must be shifted past this list's buckets.
+                    if constexpr (INDEX_LINKS) {
+                        auto shift = [offset = storage.buckets.size() - 1](size_t bucket_index) { return bucket_index + offset; };
+                        for (size_t bucket_index = 1; bucket_index < other_storage.buckets.size(); bucket_index++) {
+                            auto& bucket = other.writable_bucket(bucket_index);
+                            for (size_t i = 0; i < bucket.initialized; i++)
+                                relabel(bucket.nodes[i], shift);
+                        }
+                        first = relabel(first, shift);
+                        last = relabel(last, shift);
+                        other_storage.first_hole = relabel(other_storage.first_hole, shift);
+                        other_storage.last_hole = relabel(other_storage.last_hole, shift);
+                    }
+
+                    // Insert other's buckets into this.
+                    storage.buckets.insert(storage.buckets.end(), other_storage.buckets.begin() + 1, other_storage.buckets.end());
+                    other_storage.buckets.resize(1);
+                    index_bucket_addresses();
+                    other.index_bucket_addresses();
+                    storage.size += other_storage.size;
+                    storage.capacity += other_storage.capacity;
+                    if (storage.frontier == 0)
+                        storage.frontier = find_frontier();
+
+                    // Link the holes.
+                    link_two_nodes(storage.last_hole, other_storage.first_hole);
+                    if (storage.first_hole == NULL_LINK)
+                        storage.first_hole = other_storage.first_hole;
+                    if (other_storage.last_hole != NULL_LINK)
+                        storage.last_hole = other_storage.last_hole;
+
+                    // Link the elements to pos.
+                    auto prev = at(pos.m_link).prev();
+                    link_two_nodes(last, pos.m_link);
+                    link_two_nodes(prev, first);
+                    m_size += other.m_size;
+
+                    // Hard reset other. Its elements and buckets now belong to this.
+                    other.link_two_nodes(other.end_link(), other.end_link());
+                    other_storage.first_hole = NULL_LINK;
+                    other_storage.last_hole = NULL_LINK;
+                    other_storage.frontier = 0;
+                    other_storage.size = 0;
+                    other_storage.capacity = 0;
+                    other_storage.compaction = {};
+                    other.m_size = 0;
+                }
+                void splice(const_iterator pos, vec_list&& other) { splice(pos, other); }
+
+                // These splice functions are only optimized like they are for std::list between lists of the same pool.
+                // Otherwise the elements are moved, which invalidates iterators/references to them.
+                void splice(const_iterator pos, vec_list& other, const_iterator it) {
+                    if (m_storage == other.m_storage)
+                        return transfer(pos.m_link, other, it.m_link, other.at(it.m_link).next, 1);
+                    if constexpr (std::movable<T>) {
+                        this->insert(pos, std::move(*other.make_iterator(it.m_link)));
+                        other.erase(it);
+                    }
+                    else {
+                        throw std::invalid_argument("Non-movable elements can only be spliced between lists of the same pool.");
+                    }
+                }
+                void splice(const_iterator pos, vec_list&& other, const_iterator it) { splice(pos, other, it); }
+
+                void splice(const_iterator pos, vec_list& other, const_iterator first, const_iterator last) {
+                    if (first == other.begin() && last == other.end() && this != &other)
+                        return splice(pos, other);
+                    if (m_storage == other.m_storage) {
+                        // Only the size needs a traversal, and not even that within the same list.
+                        size_t count = this == &other ? 0 : std::distance(first, last);
+                        return transfer(pos.m_link, other, first.m_link, last.m_link, count);
+                    }
+                    if constexpr (std::movable<T>) {
+                        this->insert(pos, std::make_move_iterator(other.make_iterator(first.m_link)), std::make_move_iterator(other.make_iterator(last.m_link)));
+                        other.erase(first, last);
+                    }
+                    else {
+                        throw std::invalid_argument("Non-movable elements can only be spliced between lists of the same pool.");
+                    }
+                }
+                void splice(const_iterator pos, vec_list&& other, const_iterator first, const_iterator last) { splice(pos, other, first, last); }
+
+                // Makes the list as contiguous as possible.
+                // Lists sharing a pool are left alone since the nodes of the other lists cannot be moved.
+                void optimize(bool shrink_to_fit) requires std::movable<T> {
+                    if (m_storage == nullptr || is_storage_shared())
+                        return;
+                    auto& storage = *m_storage;
+                    auto& buckets = storage.buckets;
+
+                    if (m_size == 0) {
+                        if (shrink_to_fit) {
+                            for (size_t i = 1; i < buckets.size(); i++)
+                                deallocate_bucket(buckets[i]);
+                            buckets.resize(1);
+                            index_bucket_addresses();
+                            storage.capacity = 0;
+                            storage.frontier = 0;
+                        }
+                        clear();    // Clear organizes the holes.
+                        return;
+                    }
+
+                    // Sort the buckets in descending order of size.
+                    auto bucket_order = buckets_by_size();
+
+                    // Find the destination buckets. Make them just large enough to contain all the points.
+                    size_t dst_capacity = 0;
+                    rebind_vector<size_t> dst_buckets(get_allocator());
+                    rebind_vector<size_t> unused_buckets(get_allocator());
+                    for (size_t i = 0; i < bucket_order.size(); i++) {
+                        // Take the bucket if:
+                        // -it is below or at capacity.
+                        // -it is above capacity but the next bucket is below capacity/doesnt exist.
+                        size_t capacity_if_we_include_bucket = dst_capacity + buckets[bucket_order[i]].size;
+                        bool take_bucket = (dst_capacity < m_size) && ((capacity_if_we_include_bucket <= m_size) || (i + 1 == bucket_order.size()) || (dst_capacity + buckets[bucket_order[i + 1]].size < m_size));
+                        if (take_bucket) {
+                            dst_capacity = capacity_if_we_include_bucket;
+                            dst_buckets.push_back(bucket_order[i]);
+                        }
+                        else {
+                            unused_buckets.push_back(bucket_order[i]);
+                        }
+                    }
+                    assert(dst_capacity >= m_size);
+
+                    // Copy over the elements.
+                    auto last = end_link();
+                    auto src_node = m_sentinel.next;
+                    size_t dst_bucket_index = 0;
+                    size_t dst_elem_index = 0;
+                    auto prev = last;
+                    while (src_node != last) {
+                        // Get the dst node.
+                        assert(!at(src_node).is_hole());
+                        auto& dst_bucket = buckets[dst_buckets[dst_bucket_index]];
+                        if (dst_elem_index == dst_bucket.initialized) {
+                            // Untouched nodes are holes.
+                            touch_node(dst_buckets[dst_bucket_index]);
+                            dst_bucket.nodes[dst_elem_index].set_hole(true);
+                            dst_bucket.initialized++;
+                        }
+                        auto dst_node = make_link(dst_buckets[dst_bucket_index], dst_elem_index++);
+                        if (dst_elem_index == dst_bucket.size) {
+                            dst_elem_index = 0;
+                            dst_bucket_index++;
+                        }
+                        if (src_node != dst_node) {
+                            // Swap it with the source node and update the links.
+                            auto& src = at(src_node);
+                            auto& dst = at(dst_node);
+                            if (dst.is_hole()) {
+                                construct_element(dst, std::move(src.elem));
+                                destroy_element(src);
+                            }
+                            else {
+                                at(dst.prev()).next = src_node;
+                                at(dst.next).set_prev(src_node);
+                                std::swap(src.elem, dst.elem);
+                            }
+                            std::swap(src.next, dst.next);
+                            std::swap(src.prev_and_flag, dst.prev_and_flag);
+                        }
+                        link_two_nodes(prev, dst_node);
+                        prev = dst_node;
+                        src_node = at(dst_node).next;
+                    }
+                    link_two_nodes(prev, last);
+
+                    // Deal with unused buckets. The holes are not needed anymore, so every node past the elements becomes untouched.
+                    storage.first_hole = NULL_LINK;
+                    storage.last_hole = NULL_LINK;
+                    size_t partial_bucket = dst_elem_index > 0 ? dst_buckets[dst_bucket_index] : 0;
+                    if (shrink_to_fit) {
+                        // Remove unused buckets. This renumbers the buckets, so index links must be remapped.
+                        std::sort(dst_buckets.begin(), dst_buckets.end());
+                        rebind_vector<size_t> new_bucket_indices(buckets.size(), get_allocator());
+                        for (size_t i = 0; i < dst_buckets.size(); i++)
+                            new_bucket_indices[dst_buckets[i]] = i + 1;
+                        if constexpr (INDEX_LINKS) {
+                            auto remap = [&](size_t bucket_index) { return new_bucket_indices[bucket_index]; };
+                            auto current = last;
+                            do {
+                                auto next = at(current).next;
+                                relabel(at(current), remap);
+                                current = next;
+                            } while (current != last);
+                        }
+                        for (auto bucket_index : unused_buckets)
+                            deallocate_bucket(buckets[bucket_index]);
+                        for (size_t i = 0; i < dst_buckets.size(); i++)
+                            buckets[i + 1] = buckets[dst_buckets[i]];
+                        buckets.resize(dst_buckets.size() + 1);
+                        index_bucket_addresses();
+                        storage.capacity = dst_capacity;
+                        partial_bucket = new_bucket_indices[partial_bucket];
+                    }
+                    else {
+                        for (auto bucket_index : unused_buckets)
+                            buckets[bucket_index].initialized = 0;
+                    }
+
+                    // Use the remaining portion of the last bucket first so new elements are contiguous with the existing ones.
+                    if (partial_bucket != 0)
+                        buckets[partial_bucket].initialized = dst_elem_index;
+                    storage.frontier = partial_bucket != 0 ? partial_bucket : find_frontier();
+                    storage.compaction = {};
+
+                    // Every initialized node now holds an element.
+                    for (size_t bucket_index = 1; bucket_index < buckets.size(); bucket_index++)
+                        set_initialized_occupied(buckets[bucket_index]);
+                }
+
+                // Binary serialization of trivially copyable elements. The format is the number of elements and the size of an element as 64-bit integers,
+                // followed by the elements in list order, all in the native byte order.
+                [[nodiscard]] size_t serialized_size() const requires std::is_trivially_copyable_v<T> { return sizeof(serialization_header) + m_size * sizeof(T); }
+
+                // Writes the list to a stream. Errors are reported through the state of the stream.
+                void serialize(std::ostream& out) const requires std::is_trivially_copyable_v<T> {
+                    serialization_header header{ m_size, sizeof(T) };
+                    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+                    // Gather the elements in chunks so that the stream sees a few large writes.
+                    rebind_vector<char> chunk(std::min(m_size, SERIALIZATION_CHUNK_SIZE) * sizeof(T), m_allocator);
+                    size_t chunk_size = 0;
+                    for (auto& elem : *this) {
+                        std::memcpy(chunk.data() + chunk_size * sizeof(T), std::addressof(elem), sizeof(T));
+                        if (++chunk_size == SERIALIZATION_CHUNK_SIZE) {
+                            out.write(chunk.data(), chunk_size * sizeof(T));
+                            chunk_size = 0;
+                        }
+                    }
+                    out.write(chunk.data(), chunk_size * sizeof(T));
+                }
+
+                // Writes the list to a buffer of at least serialized_size() bytes. Returns the number of bytes written.
+                size_t serialize(std::span<std::byte> buffer) const requires std::is_trivially_copyable_v<T> {
+                    if (buffer.size() < serialized_size())
+                        throw std::length_error("The buffer is too small to serialize the vec_list.");
+                    serialization_header header{ m_size, sizeof(T) };
+                    std::memcpy(buffer.data(), &header, sizeof(header));
+                    auto dst = buffer.data() + sizeof(header);
+                    for (auto& elem : *this) {
+                        std::memcpy(dst, std::addressof(elem), sizeof(T));
+                        dst += sizeof(T);
+                    }
+                    return serialized_size();
+                }
+
+                // Reads a list written by serialize() into a single bucket of exactly the right size, whose nodes are in list order.
+                // The elements are copied into the nodes with memcpy instead of being constructed through the allocator.
+                // Throws std::runtime_error if the data is truncated or was written with another element size.
+                [[nodiscard]] static vec_list deserialize(std::istream& in, const Allocator& allocator = Allocator()) requires std::is_trivially_copyable_v<T> {
+                    serialization_header header;
+                    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)))
+                        throw std::runtime_error("The serialized vec_list is truncated.");
+                    check_serialization_header(header);
+                    vec_list list(allocator);
+                    rebind_vector<char> chunk(std::min<size_t>(header.size, SERIALIZATION_CHUNK_SIZE) * sizeof(T), list.m_allocator);
+                    list.append_sequential(header.size, [&](node& n, size_t i) {
+                        size_t chunk_index = i % SERIALIZATION_CHUNK_SIZE;
+                        if (chunk_index == 0) {
+                            size_t chunk_size = std::min<size_t>(header.size - i, SERIALIZATION_CHUNK_SIZE);
+                            if (!in.read(chunk.data(), chunk_size * sizeof(T)))
+                                throw std::runtime_error("The serialized vec_list is truncated.");
+                        }
+                        std::memcpy(std::addressof(n.elem), chunk.data() + chunk_index * sizeof(T), sizeof(T));
+                    });
+                    return list;
+                }
+
+                // Reads a list written by serialize() from a buffer.
+                [[nodiscard]] static vec_list deserialize(std::span<const std::byte> buffer, const Allocator& allocator = Allocator()) requires std::is_trivially_copyable_v<T> {
+                    serialization_header header;
+                    if (buffer.size() < sizeof(header))
+                        throw std::runtime_error("The serialized vec_list is truncated.");
+                    std::memcpy(&header, buffer.data(), sizeof(header));
+                    check_serialization_header(header);
+                    if ((buffer.size() - sizeof(header)) / sizeof(T) < header.size)
+                        throw std::runtime_error("The serialized vec_list is truncated.");
+                    vec_list list(allocator);
+                    auto src = buffer.data() + sizeof(header);
+                    list.append_sequential(header.size, [&](node& n, size_t i) { std::memcpy(std::addressof(n.elem), src + i * sizeof(T), sizeof(T)); });
+                    return list;
+                }
+
+                // Returns statistics about the memory layout. This scans the bitmaps and the nodes of this list in memory order to measure the locality.
+                [[nodiscard]] stats_type stats() const {
+                    stats_type stats{ .buckets = rebind_vector<typename stats_type::bucket_stats>(m_allocator) };
+                    if (m_storage == nullptr)
+                        return stats;
+                    auto& buckets = m_storage->buckets;
+                    stats.buckets.reserve(buckets.size() - 1);
+                    stats.nb_holes = m_storage->capacity - m_storage->size;
+                    stats.hole_list_length = stats.nb_holes;
+                    for (size_t i = 1; i < buckets.size(); i++) {
+                        if (buckets[i].nodes == nullptr)
+                            continue;
+                        auto& bucket = stats.buckets.emplace_back(buckets[i].size, buckets[i].nb_occupied, buckets[i].size - buckets[i].initialized);
+                        stats.hole_list_length -= bucket.nb_untouched;
+                    }
+
+                    // Count the links to the adjacent node. The last element links to the sentinel, which is never adjacent.
+                    if (m_size > 1) {
+                        size_t nb_adjacent = 0;
+                        for_each_node_unordered([&](const node& n) { nb_adjacent += &peek(n.next) == &n + 1; });
+                        stats.locality = double(nb_adjacent) / double(m_size - 1);
+                    }
+                    return stats;
+                }
+
+                // Compacts the list a little at a time, so that the work can be spread over idle moments. Returns true once the list is compact.
+                // Elements are moved from the end of the buckets (sorted by decreasing size like optimize()) to the first holes, until the elements fill the first size() nodes.
+                // Unlike optimize(), the elements are not laid out in list order. Only iterators/references to the moved elements are invalidated.
+                // Moving an element and scanning 64 nodes for holes or elements each consume one unit of the budget. The list can be modified between steps.
+                // Lists sharing their storage with other lists are left alone, like optimize().
+                bool optimize_step(size_t budget) requires std::movable<T> {
+                    if (m_storage == nullptr || is_storage_shared() || m_size == 0)
+                        return true;
+                    auto& storage = *m_storage;
+                    auto& buckets = storage.buckets;
+                    auto bucket_order = buckets_by_size();
+                    auto& cursor = storage.compaction;
+                    if (cursor.nb_buckets != buckets.size())
+                        cursor = { .nb_buckets = buckets.size() };
+
+                    // Converts a position to the link of its node.
+                    auto to_node = [&](size_t position) {
+                        for (auto bucket_index : bucket_order) {
+                            if (position < buckets[bucket_index].size)
+                                return std::pair(bucket_index, position);
+                            position -= buckets[bucket_index].size;
+                        }
+                        assert(false);
+                        return std::pair(size_t(0), size_t(0));
+                    };
+
+                    while (true) {
+                        auto hole_position = find_hole_to_fill(bucket_order, cursor.low, m_size, budget);
+                        auto elem_position = hole_position == SIZE_MAX ? SIZE_MAX : find_element_to_move(bucket_order, cursor.high, m_size, budget);
+                        if (elem_position == SIZE_MAX) {
+                            if (budget == 0)
+                                return false;
+
+                            // The pass is over. Unless it moved nothing, start another one since the list could have changed between steps.
+                            bool is_compact = !cursor.moved;
+                            cursor = { .nb_buckets = buckets.size() };
+                            if (is_compact)
+                                return true;
+                            continue;
+                        }
+                        if (budget == 0)
+                            return false;
+                        budget--;
+
+                        // Move the element to the hole. Construct it before touching any link in case the constructor throws.
+                        auto [hole_bucket_index, hole_elem_index] = to_node(hole_position);
+                        auto [elem_bucket_index, elem_elem_index] = to_node(elem_position);
+                        auto& hole_bucket = buckets[hole_bucket_index];
+                        auto hole = make_link(hole_bucket_index, hole_elem_index);
+                        auto elem = make_link(elem_bucket_index, elem_elem_index);
+                        bool is_untouched = hole_elem_index == hole_bucket.initialized;
+                        if (is_untouched) {
+                            touch_node(hole_bucket_index);
+                            at(hole).set_hole(true);
+                        }
+                        auto& hole_node = at(hole);
+                        auto& elem_node = at(elem);
+                        construct_element(hole_node, std::move(elem_node.elem));
+                        destroy_element(elem_node);
+                        if (is_untouched) {
+                            if (++hole_bucket.initialized == hole_bucket.size && storage.frontier == hole_bucket_index)
+                                storage.frontier = find_frontier();
+                        }
+                        else {
+                            unlink_hole(hole);
+                        }
+
+                        // The hole takes the place of the element in the list, and the element's node becomes the last hole so it is reused last.
+                        hole_node.set_hole(false);
+                        set_occupied(hole, true);
+                        link_two_nodes(elem_node.prev(), hole);
+                        link_two_nodes(hole, elem_node.next);
+                        elem_node.set_hole(true);
+                        set_occupied(elem, false);
+                        append_hole(elem);
+                        cursor.low = hole_position + 1;
+                        cursor.high = elem_position;
+                        cursor.moved = true;
+                    }
+                }
+
+                // Frees every bucket which holds no element, even if the storage is shared. No element moves, so every iterator/reference stays valid.
+                // Returns the number of freed nodes.
+                size_t release_empty_buckets() {
+                    if (m_storage == nullptr)
+                        return 0;
+                    size_t capacity = m_storage->capacity;
+                    for (size_t bucket_index = 1; bucket_index < m_storage->buckets.size(); bucket_index++) {
+                        if (m_storage->buckets[bucket_index].nodes != nullptr && m_storage->buckets[bucket_index].nb_occupied == 0)
+                            release_bucket(bucket_index);
+                    }
+                    return capacity - m_storage->capacity;
+                }
+
+                // Returns the memory of the holes at the end of each bucket to the operating system, even if the storage is shared.
+                // Those holes become untouched nodes again, so their pages are only faulted back in once they are reused. No element moves,
+                // so every iterator/reference stays valid. Only whole pages can be returned. Returns the number of bytes returned, which is always 0 outside of Linux.
+                size_t trim() {
+#if defined(__linux__)
+                    if (m_storage == nullptr)
+                        return 0;
+                    auto& storage = *m_storage;
+                    auto page_size = static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+                    size_t nb_bytes = 0;
+                    for (size_t bucket_index = 1; bucket_index < storage.buckets.size(); bucket_index++) {
+                        auto& bucket = storage.buckets[bucket_index];
+                        if (bucket.nodes == nullptr || bucket.frozen != nullptr)
+                            continue;
+
+                        // Find the last element of the bucket.
+                        size_t word = nb_bitmap_words(bucket);
+                        while (word > 0 && bucket.occupied[word - 1] == 0)
+                            word--;
+                        size_t nb_used = word == 0 ? 0 : word * BITS_PER_WORD - std::countl_zero(bucket.occupied[word - 1]);
+
+                        // The pages past the last element may still be resident even if the nodes are untouched, for example after clear().
+                        auto first_page = (reinterpret_cast<std::uintptr_t>(bucket.nodes + nb_used) + page_size - 1) & ~(page_size - 1);
+                        auto last_page = reinterpret_cast<std::uintptr_t>(bucket.nodes + bucket.size) & ~(page_size - 1);
+                        if (first_page >= last_page)
+                            continue;
+
+                        // The trailing holes must leave the hole list before their memory is discarded.
+                        for (size_t elem_index = nb_used; elem_index < bucket.initialized; elem_index++)
+                            unlink_hole(make_link(bucket_index, elem_index));
+                        bucket.initialized = std::min(bucket.initialized, nb_used);
+                        bucket.first_free = std::min(bucket.first_free, nb_used);
+                        if (madvise(reinterpret_cast<void*>(first_page), last_page - first_page, MADV_DONTNEED) == 0)
+                            nb_bytes += last_page - first_page;
+                    }
+                    storage.frontier = find_frontier();
+                    storage.compaction = {};
+                    return nb_bytes;
+#else
+                    return 0;
+#endif
+                }
+
+                // Frees buckets automatically as soon as their last element is erased, unless fewer than min_free_nodes free nodes would remain.
+                // Like the hole policy, this belongs to the storage. Setting it creates the storage if needed.
+                void set_auto_release(bool enabled, size_t min_free_nodes = 0) {
+                    auto& storage = get_storage();
+                    storage.auto_release = enabled;
+                    storage.auto_release_min_free = min_free_nodes;
+                }
+
+                // Returns a read-only view of the list as it is now, without copying any element. The buckets are shared with the snapshot
+                // until the list first modifies each of them, which copies that bucket. Only index links are supported, since copying a bucket
+                // must not invalidate the links to its nodes. Copying a bucket invalidates references to its elements, but not iterators.
+                [[nodiscard]] snapshot_type snapshot() requires (INDEX_LINKS && std::copy_constructible<T>) {
+                    snapshot_type result(m_allocator);
+                    result.copy_sentinel(m_sentinel);
+                    result.m_size = m_size;
+                    if (m_storage == nullptr)
+                        return result;
+                    auto& buckets = m_storage->buckets;
+                    result.m_buckets.resize(buckets.size(), nullptr);
+                    rebind_allocator<frozen_nodes> frozen_allocator(m_allocator);
+                    for (size_t bucket_index = 1; bucket_index < buckets.size(); bucket_index++) {
+                        auto& bucket = buckets[bucket_index];
+                        if (bucket.nodes == nullptr)
+                            continue;
+                        if (bucket.frozen == nullptr) {
+                            auto frozen = std::allocator_traits<rebind_allocator<frozen_nodes>>::allocate(frozen_allocator, 1);
+                            bucket.frozen = std::construct_at(frozen);
+                            bucket.frozen->nodes = bucket.nodes;
+                            bucket.frozen->size = bucket.size;
+                            bucket.frozen->initialized = bucket.initialized;
+                            bucket.frozen->huge_pages = bucket.huge_pages;
+                        }
+                        bucket.frozen->nb_owners.fetch_add(1, std::memory_order_relaxed);
+                        result.m_buckets[bucket_index] = bucket.frozen;
+                    }
+                    return result;
+                }
+
+                // Returns the fraction of the elements which optimize_step() does not need to move, from 0 to 1.
+                [[nodiscard]] double optimize_progress() const {
+                    if (m_storage == nullptr || is_storage_shared() || m_size == 0)
+                        return 1;
+
+                    // Count the elements past the first size() nodes.
+                    auto& buckets = m_storage->buckets;
+                    size_t start = 0;
+                    size_t nb_misplaced = 0;
+                    for (auto bucket_index : buckets_by_size()) {
+                        auto& bucket = buckets[bucket_index];
+                        size_t first = std::max(m_size, start) - start;
+                        for (size_t word = first / BITS_PER_WORD; word < nb_bitmap_words(bucket); word++) {
+                            auto bits = bucket.occupied[word];
+                            if (word == first / BITS_PER_WORD)
+                                bits &= ~std::uint64_t(0) << (first % BITS_PER_WORD);
+                            nb_misplaced += std::popcount(bits);
+                        }
+                        start += bucket.size;
+                    }
+                    return 1 - double(nb_misplaced) / double(m_size);
+                }
+            };
+
+
+            // A pool of nodes shared by many lists, so that small lists don't each allocate their own buckets.
+            // Lists created from the pool only own their sentinel and size, and can splice partial ranges to each other without moving any element.
+            // The nodes are freed once the pool and every list created from it are destroyed. Like the lists, the pool is not thread-safe.
+            template<class T, class Links = pointer_links, class Allocator = std::allocator<T>>
+            class vec_list_pool {
+            public:
+                using list_type = vec_list<T, Links, Allocator>;
+
+                // Constructors.
+                vec_list_pool() : vec_list_pool(Allocator()) {}
+                explicit vec_list_pool(const Allocator& allocator) : m_list(allocator) { m_list.get_storage(); }
+
+                vec_list_pool(const vec_list_pool&) = delete;
+                vec_list_pool& operator=(const vec_list_pool&) = delete;
+
+                // Accessors.
+                [[nodiscard]] size_t size() const { return m_list.m_storage->size; }                // Number of elements in every list of the pool.
+                [[nodiscard]] size_t capacity() const { return m_list.m_storage->capacity; }        // Number of elements which fit before needing another allocation.
+                [[nodiscard]] Allocator get_allocator() const { return m_list.get_allocator(); }
+
+                // The hole policy of every list of the pool.
+                [[nodiscard]] hole_policy get_hole_policy() const { return m_list.get_hole_policy(); }
+                void set_hole_policy(hole_policy policy) { m_list.set_hole_policy(policy); }
+
+                // Whether the large buckets of the pool are mapped on huge pages.
+                [[nodiscard]] bool get_huge_pages() const { return m_list.get_huge_pages(); }
+                void set_huge_pages(bool enabled) { m_list.set_huge_pages(enabled); }
+
+                // Frees the buckets which hold no element of any list of the pool, manually or automatically.
+                size_t release_empty_buckets() { return m_list.release_empty_buckets(); }
+                void set_auto_release(bool enabled, size_t min_free_nodes = 0) { m_list.set_auto_release(enabled, min_free_nodes); }
+
+                // Returns the memory of the holes at the end of each bucket of the pool to the operating system.
+                size_t trim() { return m_list.trim(); }
+
+                // Reserves more memory for every list of the pool.
+                void reserve(size_t new_capacity) { m_list.resize_to_fit(new_capacity - size(), true); }
+
+            private:
+                friend list_type;
+                list_type m_list;   // Empty list whose storage is shared by every list of the pool.
+            };
+
+
+
+#if defined(__linux__)
+            // A vec_list of trivially copyable elements whose nodes live in a memory-mapped file, so it can be reopened without any deserialization.
+            // Nodes are linked with 32-bit (bucket, offset) indices like index_links, since the buckets are mapped at different addresses every time.
+            // The file starts with a header holding the sentinel, the hole list and the location of each bucket. Buckets are appended to the file
+            // with the same geometric growth as vec_list and are never moved, so iterators/references stay valid until the list is closed.
+            // Every change is written to the file as it happens, but flush() must be called to make it durable before a system crash.
+            // The list is limited to 30 buckets of 2^26 elements. Reopening a file with another element type throws std::runtime_error.
             template<class T>
-            class vec_list {
+            class mapped_vec_list {
+                static_assert(std::is_trivially_copyable_v<T>, "mapped_vec_list requires a trivially copyable T.");
+
             private:
                 // Private types.
-
-                // Struct for elements.
+                using link = std::uint32_t;
+
+                // Link layout, identical to index_links.
+                static constexpr size_t OFFSET_BITS = 26;
+                static constexpr link OFFSET_MASK = (link(1) << OFFSET_BITS) - 1;
+                static constexpr size_t MAX_BUCKETS = 31;
+                static constexpr size_t MAX_BUCKET_SIZE = size_t(1) << OFFSET_BITS;
+                static constexpr link NULL_LINK = 0x7FFFFFFF;
+                static constexpr link SENTINEL_LINK = 0;
+                static constexpr link HOLE_FLAG = link(1) << 31;
+
+                // Struct for elements. A node is exactly 2 links and a T.
                 struct node {
-                    node* next = nullptr;
-                    node* prev = nullptr;
-                    std::optional<T> elem;  // TODO optimize the optional by fudging the pointers in unused bits and directly storing a union of T and char.
+                    link next = NULL_LINK;
+                    link prev_and_flag = NULL_LINK;
+                    union { T elem; };  // Only alive when the node is not a hole.
+
+                    node() {}
+
+                    link prev() const { return prev_and_flag & ~HOLE_FLAG; }
+                    void set_prev(link prev) { prev_and_flag = prev | (prev_and_flag & HOLE_FLAG); }
+                    bool is_hole() const { return prev_and_flag & HOLE_FLAG; }
+                    void set_hole(bool is_hole) { prev_and_flag = (prev_and_flag & ~HOLE_FLAG) | (is_hole ? HOLE_FLAG : 0); }
                 };
 
-                // Iterators, templated for constness.
+                // Where a bucket lives in the file. Bucket 0 is never used since index 0 is the sentinel.
+                struct bucket_location {
+                    std::uint64_t offset = 0;       // In bytes from the start of the file. Always a multiple of the page size.
+                    std::uint64_t size = 0;         // Number of nodes.
+                    std::uint64_t initialized = 0;  // Nodes at or past this index are untouched. They count as holes but are not part of the hole list.
+                };
+
+                // Identifies the file format. The lowest byte is the version.
+                static constexpr std::uint64_t MAGIC = 0x7473696C63657601;
+
+                // FNV-1a hash of the mangled name of T, which is the same in every program built for the same platform.
+                static std::uint64_t hash_type_name() {
+                    std::uint64_t hash = 0xCBF29CE484222325;
+                    for (const char* c = typeid(T).name(); *c != '\0'; c++)
+                        hash = (hash ^ static_cast<unsigned char>(*c)) * 0x100000001B3;
+                    return hash;
+                }
+
+                // The start of the file. Only fixed-size fields so that the layout does not depend on the compiler.
+                struct file_header {
+                    std::uint64_t magic = MAGIC;
+                    std::uint64_t node_size = sizeof(node);
+                    std::uint64_t node_alignment = alignof(node);
+                    std::uint64_t type_hash = hash_type_name();     // Tells apart element types of the same size.
+                    std::uint64_t size = 0;         // Number of elements.
+                    std::uint64_t capacity = 0;     // Number of elements and holes, including untouched nodes.
+                    std::uint64_t nb_buckets = 1;   // Including the unused bucket 0.
+                    link first_hole = NULL_LINK;    // Holes form a forward list. When an element is erased, it becomes the new first hole.
+                    bucket_location buckets[MAX_BUCKETS];
+                    node sentinel;
+                };
+
+                // Iterators, templated for constness. Like index_links, they refer to the list to resolve links.
                 template<class U>
                 class iterator_impl {
                 private:
-                    // Private constructor so vec_list can create a valid iterator.
-                    friend class vec_list;
-                    explicit iterator_impl(node* node) : m_node(node) {}
+                    // Private constructor so mapped_vec_list can create a valid iterator.
+                    friend class mapped_vec_list;
+                    template<class> friend class iterator_impl;
+                    explicit iterator_impl(link link, const mapped_vec_list* list) : m_link(link), m_list(list) {}
+
+                    node& get() const { return m_list->at(m_link); }
 
                     // Private members.
-                    node* m_node = nullptr; // The iterator is basically a wrapper around a node.
+                    link m_link = NULL_LINK;
+                    const mapped_vec_list* m_list = nullptr;
 
                 public:
                     // Types required to satisfy std::bidirectional_iterator.
@@ -47,86 +2651,144 @@ namespace palla {
                     iterator_impl() = default;
 
                     // Indirection.
-                    U& operator*() const { return *m_node->elem; }
+                    U& operator*() const { return get().elem; }
                     U* operator->() const { return &**this; }
 
                     // Increment and decrement.
-                    iterator_impl& operator++() { assert(m_node->next); *this = iterator(m_node->next); return *this; }
+                    iterator_impl& operator++() { assert(get().next != NULL_LINK); m_link = get().next; return *this; }
                     iterator_impl operator++(int) { iterator_impl current = *this; ++(*this); return current; }
 
-                    iterator_impl& operator--() { assert(m_node->prev); *this = iterator(m_node->prev); return *this; }
+                    iterator_impl& operator--() { assert(get().prev() != NULL_LINK); m_link = get().prev(); return *this; }
                     iterator_impl operator--(int) { iterator_impl current = *this; --(*this); return current; }
 
                     // Comparison.
-                    friend bool operator==(const iterator_impl& a, const iterator_impl& b) { return a.m_node == b.m_node; }
+                    friend bool operator==(const iterator_impl& a, const iterator_impl& b) { return a.m_link == b.m_link; }
 
                     // Conversion from mutable to const.
-                    template<class = std::enable_if_t<!std::is_const_v<U>>>
-                    operator iterator_impl<const U>() const { return iterator_impl<const U>(m_node); }
-
+                    operator iterator_impl<const U>() const requires (!std::is_const_v<U>) { return iterator_impl<const U>(m_link, m_list); }
                 };
 
-
                 // Private members.
-                std::vector<std::vector<node>> m_buckets;   // List of buckets because they are never deleted. The first bucket is always 2 elements: begin and end.
-                node* m_first_hole = nullptr;               // First hole. Holes form a forward list embedded within this list. When an element is erased, it becomes the new first hole.
-                node* m_last_hole = nullptr;                // Last hole. Used for splicing lists together.
-                size_t m_size = 0;                          // Number of elements (not holes).
-                size_t m_capacity = 0;                      // Number of elements and holes.
+                int m_file = -1;
+                file_header* m_header = nullptr;
+                node* m_buckets[MAX_BUCKETS] = {};  // Where each bucket is mapped in this process.
+                size_t m_frontier = 0;              // First bucket with untouched nodes, 0 if there are none. Not stored in the file since it is cheap to find again.
 
-                // Expansion constants.
+                // Expansion constants, identical to vec_list.
                 static constexpr size_t MIN_BUCKET_SIZE = 16;
                 static constexpr double GROWTH_FACTOR = 2;
 
                 // Private functions.
 
-                // Resizes to fit at least nb_holes new elements.
-                // At the end of this function, m_first_hole should be valid.
-                void resize_to_fit(std::int64_t nb_new_elements, bool is_reserve = false) {
-                    auto capacity_required = m_size + nb_new_elements;
-                    if (capacity_required <= m_capacity)
-                        return;
+                // Throws the last error of a system call.
+                [[noreturn]] static void throw_system_error(const char* what) { throw std::system_error(errno, std::generic_category(), what); }
 
-                    // The new bucket should be either the minimum size or enough to fit all the required elements, whichever is larger.
-                    size_t bucket_size = std::max(MIN_BUCKET_SIZE, capacity_required - m_capacity);
+                static size_t page_size() { return static_cast<size_t>(sysconf(_SC_PAGESIZE)); }
+                static size_t round_to_pages(size_t nb_bytes) { return (nb_bytes + page_size() - 1) / page_size() * page_size(); }
+                static size_t header_length() { return round_to_pages(sizeof(file_header)); }
 
-                    // Unless this is reserve(), we should also respect the growth factor.
-                    if (!is_reserve)
-                        bucket_size = std::max(bucket_size, (size_t)std::ceil(m_capacity * (GROWTH_FACTOR - 1)));
+                // Maps a region of the file.
+                void* map(size_t offset, size_t length) {
+                    void* memory = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, m_file, static_cast<off_t>(offset));
+                    if (memory == MAP_FAILED)
+                        throw_system_error("mapped_vec_list could not map its file");
+                    return memory;
+                }
+
+                // Unmaps everything and closes the file.
+                void close() noexcept {
+                    if (m_header != nullptr) {
+                        for (size_t bucket_index = 1; bucket_index < m_header->nb_buckets; bucket_index++)
+                            munmap(m_buckets[bucket_index], round_to_pages(m_header->buckets[bucket_index].size * sizeof(node)));
+                        munmap(m_header, header_length());
+                    }
+                    if (m_file != -1)
+                        ::close(m_file);
+                    m_file = -1;
+                    m_header = nullptr;
+                    std::fill(std::begin(m_buckets), std::end(m_buckets), nullptr);
+                    m_frontier = 0;
+                }
+
+                // Resolves a link.
+                node& at(link l) const {
+                    assert(l != NULL_LINK);
+                    if (l == SENTINEL_LINK)
+                        return m_header->sentinel;
+                    return m_buckets[l >> OFFSET_BITS][l & OFFSET_MASK];
+                }
+
+                static link make_link(size_t bucket_index, size_t elem_index) { return link((bucket_index << OFFSET_BITS) | elem_index); }
 
-                    // Add the bucket.
-                    m_capacity += bucket_size;
-                    m_buckets.emplace_back(bucket_size);
-                    fill_bucket_with_holes(m_buckets.size() - 1, 0);
-                    assert(m_first_hole);
+                void link_two_nodes(link first, link second) {
+                    at(first).next = second;
+                    at(second).set_prev(first);
                 }
 
-                // Fills a bucket with holes. Used to reset buckets.
-                void fill_bucket_with_holes(size_t bucket_index, size_t elem_index) {
-                    assert(bucket_index > 0 && bucket_index < m_buckets.size());                    // Cannot fill bucket 0 because it contains begin and end.
-                    auto& bucket = m_buckets[bucket_index];
-                    assert(elem_index < bucket.size());
-                    assert(m_first_hole < &bucket[elem_index] || m_first_hole > &bucket.back());    // The first hole should never be part of this bucket.
+                iterator_impl<T> make_iterator(link l) const { return iterator_impl<T>(l, this); }
 
-                    // Clear the bucket.
-                    for (size_t i = elem_index; i < bucket.size(); i++) {
-                        bucket[i].next = &bucket[i] + 1;
-                        bucket[i].prev = &bucket[i] - 1;
-                        bucket[i].elem = std::nullopt;
+                // Returns the first bucket at or after first_bucket which still has untouched nodes, or 0 if there are none.
+                size_t find_frontier(size_t first_bucket = 1) const {
+                    for (size_t bucket_index = first_bucket; bucket_index < m_header->nb_buckets; bucket_index++) {
+                        if (m_header->buckets[bucket_index].initialized < m_header->buckets[bucket_index].size)
+                            return bucket_index;
                     }
+                    return 0;
+                }
+
+                // Appends buckets to the file to fit at least nb_new_elements new elements, like vec_list::resize_to_fit().
+                void resize_to_fit(size_t nb_new_elements, bool is_reserve = false) {
+                    auto& header = *m_header;
+                    auto capacity_required = header.size + nb_new_elements;
+                    if (nb_new_elements == 0 || capacity_required <= header.capacity)
+                        return;
+                    if (capacity_required > max_size())
+                        throw std::length_error("mapped_vec_list is too large.");
 
-                    // Link to the first hole.
-                    link_two_nodes(&bucket.back(), m_first_hole);
-                    bucket[elem_index].prev = nullptr;
-                    m_first_hole = &bucket[elem_index];
-                    if (m_last_hole == nullptr)
-                        m_last_hole = &m_buckets[bucket_index].back();
+                    // The new bucket should be either the minimum size or enough to fit all the required elements, whichever is larger.
+                    size_t bucket_size = std::max(MIN_BUCKET_SIZE, size_t(capacity_required - header.capacity));
+                    if (!is_reserve)
+                        bucket_size = std::max(bucket_size, (size_t)std::ceil(header.capacity * (GROWTH_FACTOR - 1)));
+
+                    // Index links cannot address more than MAX_BUCKET_SIZE elements per bucket, so this might need more than one.
+                    do {
+                        if (header.nb_buckets == MAX_BUCKETS)
+                            throw std::length_error("mapped_vec_list has too many buckets.");
+                        size_t current_bucket_size = std::min(bucket_size, MAX_BUCKET_SIZE);
+                        bucket_size -= current_bucket_size;
+
+                        // The new bucket starts at the end of the file, which is always a whole number of pages.
+                        auto& last = header.buckets[header.nb_buckets - 1];
+                        size_t offset = header.nb_buckets == 1 ? header_length() : last.offset + round_to_pages(last.size * sizeof(node));
+                        size_t length = round_to_pages(current_bucket_size * sizeof(node));
+                        if (ftruncate(m_file, static_cast<off_t>(offset + length)) != 0)
+                            throw_system_error("mapped_vec_list could not grow its file");
+                        m_buckets[header.nb_buckets] = static_cast<node*>(map(offset, length));
+                        header.buckets[header.nb_buckets] = { offset, current_bucket_size, 0 };
+                        header.nb_buckets++;
+                        header.capacity += current_bucket_size;
+                        if (m_frontier == 0)
+                            m_frontier = header.nb_buckets - 1;
+                    } while (bucket_size > 0 && header.capacity < capacity_required);
                 }
 
-                // Utility function which links prev and next.
-                static void link_two_nodes(node* prev, node* next) {
-                    if (next) next->prev = prev;
-                    if (prev) prev->next = next;
+                // Takes a free node, either the first hole or the first untouched node of the frontier. There must be at least one.
+                // Growing can leave untouched nodes in earlier buckets, for example after reserve(), so the frontier moves forward once its bucket is full.
+                link take_free_node() {
+                    auto& header = *m_header;
+                    if (header.first_hole != NULL_LINK) {
+                        auto l = header.first_hole;
+                        header.first_hole = at(l).next;
+                        return l;
+                    }
+                    size_t bucket_index = m_frontier;
+                    assert(bucket_index != 0);
+                    auto& bucket = header.buckets[bucket_index];
+                    std::construct_at(m_buckets[bucket_index] + bucket.initialized);
+                    auto l = make_link(bucket_index, bucket.initialized++);
+                    if (bucket.initialized == bucket.size)
+                        m_frontier = find_frontier(bucket_index + 1);
+                    return l;
                 }
 
             public:
@@ -140,50 +2802,93 @@ namespace palla {
                 using reverse_iterator = std::reverse_iterator<iterator_impl<T>>;
                 using const_reverse_iterator = std::reverse_iterator<iterator_impl<const T>>;
 
+                // Opens the list stored in a file, or creates an empty one if the file does not exist or is empty.
+                explicit mapped_vec_list(const std::filesystem::path& path) {
+                    m_file = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+                    if (m_file == -1)
+                        throw_system_error("mapped_vec_list could not open its file");
+                    try {
+                        struct stat file_stats;
+                        if (fstat(m_file, &file_stats) != 0)
+                            throw_system_error("mapped_vec_list could not read the size of its file");
+                        bool is_new = file_stats.st_size == 0;
+                        if (is_new && ftruncate(m_file, static_cast<off_t>(header_length())) != 0)
+                            throw_system_error("mapped_vec_list could not grow its file");
+                        if (!is_new && static_cast<size_t>(file_stats.st_size) < header_length())
+                            throw std::runtime_error("mapped_vec_list file is truncated.");
+                        m_header = static_cast<file_header*>(map(0, header_length()));
+
+                        if (is_new) {
+                            std::construct_at(m_header);
+                            link_two_nodes(SENTINEL_LINK, SENTINEL_LINK);
+                            return;
+                        }
 
-                // Public functions.
-
-                // Constructors.
-                vec_list() { m_buckets.emplace_back(2); clear(); }
+                        // Check that the file was written with the same element type.
+                        auto& header = *m_header;
+                        if (header.magic != MAGIC || header.node_size != sizeof(node) || header.node_alignment != alignof(node) || header.type_hash != hash_type_name())
+                            throw std::runtime_error("mapped_vec_list file was not written with the same element type.");
+                        if (header.nb_buckets == 0 || header.nb_buckets > MAX_BUCKETS)
+                            throw std::runtime_error("mapped_vec_list file is corrupted.");
+                        for (size_t bucket_index = 1; bucket_index < header.nb_buckets; bucket_index++) {
+                            auto& bucket = header.buckets[bucket_index];
+                            if (bucket.offset + round_to_pages(bucket.size * sizeof(node)) > static_cast<size_t>(file_stats.st_size))
+                                throw std::runtime_error("mapped_vec_list file is truncated.");
+                            m_buckets[bucket_index] = static_cast<node*>(map(bucket.offset, round_to_pages(bucket.size * sizeof(node))));
+                        }
+                        m_frontier = find_frontier();
+                    }
+                    catch (...) {
+                        close();
+                        throw;
+                    }
+                }
 
-                template<class it>
-                    requires std::forward_iterator<it>
-                vec_list(it first, it last) : vec_list() { insert(begin(), first, last); }
-                vec_list(std::initializer_list<T> list) : vec_list(list.begin(), list.end()) {}
-
-                vec_list(size_t count, const T& value) : vec_list() { insert(begin(), count, value); }
-                vec_list(size_t count) : vec_list() { for (size_t i = 0; i < count; i++) insert(begin(), T{}); }
-
-                // vec_list is always movable, even if T is not.
-                vec_list(vec_list&& other) : vec_list() { *this = std::move(other); }
-                vec_list& operator=(vec_list&& other) noexcept {
-                    m_buckets = std::move(other.m_buckets); other.m_buckets.clear();
-                    m_first_hole = std::exchange(other.m_first_hole, nullptr);
-                    m_last_hole = std::exchange(other.m_last_hole, nullptr);
-                    m_size = std::exchange(other.m_size, 0);
-                    m_capacity = std::exchange(other.m_capacity, 0);
+                // A mapped_vec_list owns its file, so it cannot be copied. Moving it invalidates iterators like index_links.
+                mapped_vec_list(const mapped_vec_list&) = delete;
+                mapped_vec_list& operator=(const mapped_vec_list&) = delete;
+                mapped_vec_list(mapped_vec_list&& other) noexcept { swap(other); }
+                mapped_vec_list& operator=(mapped_vec_list&& other) noexcept {
+                    if (this != &other) {
+                        close();
+                        swap(other);
+                    }
                     return *this;
                 }
+                void swap(mapped_vec_list& other) noexcept {
+                    std::swap(m_file, other.m_file);
+                    std::swap(m_header, other.m_header);
+                    std::swap(m_buckets, other.m_buckets);
+                    std::swap(m_frontier, other.m_frontier);
+                }
+                friend void swap(mapped_vec_list& a, mapped_vec_list& b) noexcept { a.swap(b); }
 
-                // vec_list is copyable if T is.
-                vec_list(const vec_list& other) requires std::copyable<T> : vec_list() { *this = other; }
-                vec_list& operator=(const vec_list& other) requires std::copyable<T> {
-                    this->clear();
-                    this->insert(this->begin(), other.begin(), other.end());
-                    return *this;
+                // Closes the file. The list can be reopened later with the same path.
+                ~mapped_vec_list() { close(); }
+
+                // Writes every change to the file before returning.
+                void flush() {
+                    if (m_header == nullptr)
+                        return;
+                    for (size_t bucket_index = 1; bucket_index < m_header->nb_buckets; bucket_index++) {
+                        if (msync(m_buckets[bucket_index], round_to_pages(m_header->buckets[bucket_index].size * sizeof(node)), MS_SYNC) != 0)
+                            throw_system_error("mapped_vec_list could not flush its file");
+                    }
+                    if (msync(m_header, header_length(), MS_SYNC) != 0)
+                        throw_system_error("mapped_vec_list could not flush its file");
                 }
 
                 // Accessors.
-                [[nodiscard]] bool empty() const { return m_size == 0; }
-                [[nodiscard]] size_type size() const { return m_size; }
-                [[nodiscard]] size_type max_size() const { return m_buckets[0].max_size(); }
-                [[nodiscard]] size_type capacity() const { return m_capacity; }
+                [[nodiscard]] bool empty() const { return size() == 0; }
+                [[nodiscard]] size_type size() const { return m_header->size; }
+                [[nodiscard]] size_type max_size() const { return (MAX_BUCKETS - 1) * MAX_BUCKET_SIZE; }
+                [[nodiscard]] size_type capacity() const { return m_header->capacity; }
 
                 // Iterators.
-                [[nodiscard]] iterator begin() { return iterator(m_buckets[0][1].next); }
-                [[nodiscard]] iterator end() { return iterator(&m_buckets[0][0]); }
-                [[nodiscard]] const_iterator begin() const { return const_cast<vec_list*>(this)->begin(); }
-                [[nodiscard]] const_iterator end() const { return const_cast<vec_list*>(this)->end(); }
+                [[nodiscard]] iterator begin() { return make_iterator(m_header->sentinel.next); }
+                [[nodiscard]] iterator end() { return make_iterator(SENTINEL_LINK); }
+                [[nodiscard]] const_iterator begin() const { return const_cast<mapped_vec_list*>(this)->begin(); }
+                [[nodiscard]] const_iterator end() const { return const_cast<mapped_vec_list*>(this)->end(); }
                 [[nodiscard]] const_iterator cbegin() const { return begin(); }
                 [[nodiscard]] const_iterator cend() const { return end(); }
 
@@ -200,265 +2905,87 @@ namespace palla {
                 [[nodiscard]] reference back() { return *std::prev(end()); }
                 [[nodiscard]] const_reference back() const { return *std::prev(end()); }
 
-                // Assign.
-                template<class it>
-                void assign(it first, it last) { clear(); insert(first, last); }
-                void assign(size_t count, const T& value) requires std::copyable<T> { clear(); insert(end(), count, value); }
-                void assign(std::initializer_list<T> list) requires std::copyable<T> { assign(list.begin(), list.end()); }
-
                 // Insert.
-                iterator insert(const_iterator pos, T&& value) requires std::movable<T> { return emplace(pos, std::move(value)); }
-                iterator insert(const_iterator pos, const T& value) requires std::copyable<T> { return emplace(pos, value); }
-                void insert(const_iterator pos, std::initializer_list<T> list) requires std::copyable<T> { insert(pos, list.begin(), list.end()); }
+                iterator insert(const_iterator pos, const T& value) { return emplace(pos, value); }
 
                 template<class it>
-                    requires std::forward_iterator<it>
+                    requires std::input_iterator<it>
                 void insert(const_iterator pos, it first, it last) {
-                    resize_to_fit(std::distance(first, last));
+                    if constexpr (std::forward_iterator<it>)
+                        resize_to_fit(std::distance(first, last));
                     while (first != last)
                         insert(pos, *(first++));
                 }
 
-                void insert(const_iterator pos, size_t count, const T& value) requires std::copyable<T> {
-                    resize_to_fit(count);
-                    for (size_t i = 0; i < count; i++)
-                        insert(pos, value);
-                }
-
-                // Push and pop.
                 template<class... Ts>
-                reference emplace_back(Ts&&... args) { return *emplace(end(), std::forward<Ts>(args)...); }
-                reference push_back(T&& value) requires std::movable<T> { return emplace_back(std::move(value)); }
-                reference push_back(const T& value) requires std::copyable<T> { return emplace_back(value); }
-                void pop_back() { erase(std::prev(end())); }
+                iterator emplace(const_iterator pos, Ts&&... args) {
+                    resize_to_fit(1);
+                    auto l = take_free_node();
+                    auto& n = at(l);
+                    std::construct_at(std::addressof(n.elem), std::forward<Ts>(args)...);
+                    n.set_hole(false);
+                    link_two_nodes(at(pos.m_link).prev(), l);
+                    link_two_nodes(l, pos.m_link);
+                    m_header->size++;
+                    return make_iterator(l);
+                }
 
                 template<class... Ts>
                 reference emplace_front(Ts&&... args) { return *emplace(begin(), std::forward<Ts>(args)...); }
-                reference push_front(T&& value) requires std::movable<T> { return emplace_front(std::move(value)); }
-                reference push_front(const T& value) requires std::copyable<T> { return emplace_front(value); }
-                void pop_front() { erase(begin()); }
-
-                // Comparisons.
-                [[nodiscard]] friend bool operator==(const vec_list& a, const vec_list& b) {
-                    if (a.size() != b.size())
-                        return false;
-                    return std::equal(a.begin(), a.end(), b.begin(), b.end());
-                }
-
-                [[nodiscard]] friend auto operator<=>(const vec_list& a, const vec_list& b) {
-                    return std::lexicographical_compare_three_way(a.begin(), a.end(), b.begin(), b.end());
-                }
-
-                // Actual emplace function that does all the work.
                 template<class... Ts>
-                iterator emplace(const_iterator pos, Ts&&... args) {
-                    // If there are no more holes, add a new bucket to create new ones.
-                    if (m_first_hole == nullptr)
-                        resize_to_fit(1);
-
-                    // Fill the first hole. If it is the last one, set the last hole to nullptr.
-                    auto current = m_first_hole;
-                    m_first_hole = m_first_hole->next;
-                    if (m_first_hole == nullptr)
-                        m_last_hole = nullptr;
-
-                    // Set the element.
-                    current->elem.emplace(std::forward<Ts>(args)...);
-                    m_size++;
-
-                    // Link the element to pos.
-                    auto prev = pos.m_node->prev;
-                    link_two_nodes(current, pos.m_node);
-                    link_two_nodes(prev, current);
-                    return iterator(current);
+                reference emplace_back(Ts&&... args) { return *emplace(end(), std::forward<Ts>(args)...); }
+                reference push_front(const T& value) { return emplace_front(value); }
+                reference push_back(const T& value) { return emplace_back(value); }
+
+                // Erase. The node becomes the first hole.
+                iterator erase(const_iterator pos) {
+                    assert(pos != end());
+                    auto& n = at(pos.m_link);
+                    auto next = n.next;
+                    link_two_nodes(n.prev(), next);
+                    n.set_hole(true);
+                    n.next = m_header->first_hole;
+                    m_header->first_hole = pos.m_link;
+                    m_header->size--;
+                    return make_iterator(next);
                 }
-
-                // Actual erase function that does all the work.
-                iterator erase(const_iterator first, const_iterator last) { while (first != last) { first = erase(first); } return iterator(first.m_node); }
-                iterator erase(const_iterator it) {
-                    assert(it.m_node && it.m_node->elem.has_value());
-
-                    // Erase the element.
-                    m_size--;
-                    it.m_node->elem = std::nullopt;
-
-                    // Link the neighbors together.
-                    auto next = it.m_node->next;
-                    link_two_nodes(it.m_node->prev, it.m_node->next);
-                    link_two_nodes(it.m_node, m_first_hole);
-
-                    // Make the element the first hole.
-                    m_first_hole = it.m_node;
-                    if (m_last_hole == nullptr)
-                        m_last_hole = m_first_hole;
-
-                    return iterator(next);
+                iterator erase(const_iterator first, const_iterator last) {
+                    while (first != last)
+                        first = erase(first);
+                    return make_iterator(last.m_link);
                 }
+                void pop_front() { erase(begin()); }
+                void pop_back() { erase(std::prev(end())); }
 
-                // Clears the list.
+                // Turns every element into a hole in O(size). The file keeps its size.
                 void clear() {
-                    m_first_hole = nullptr;
-                    for (size_t bucket_index = 1; bucket_index < m_buckets.size(); bucket_index++) {
-                        fill_bucket_with_holes(bucket_index, 0);
-                    }
-                    link_two_nodes(&m_buckets[0][1], &m_buckets[0][0]);
-                    if (m_buckets.size() > 1)
-                        m_last_hole = &m_buckets.back().back();
-                    m_size = 0;
-                }
-
-                // Reserves more memory. Much like std::vector, this bypasses geometric growth and allocates only the required amount.
-                void reserve(size_t new_capacity) { resize_to_fit(new_capacity - m_capacity, true); }
-
-                // Resizes up or down by adding or removing elements at the end.
-                void resize(size_t new_size) {
-                    while (m_size > new_size)
-                        pop_back();
-                    resize_to_fit(new_size - m_size);
-                    while (m_size < new_size)
-                        emplace_back();
-                }
-
-                void resize(size_t new_size, const T& value) requires std::copyable<T> {
-                    while (m_size > new_size)
-                        pop_back();
-                    insert(end(), new_size - m_size, value);
-                }
-
-                // Reverse the list.
-                void reverse() {
-                    // Reverse the elements only. Holes can stay the same.
-                    auto first = begin().m_node->prev;
-                    auto last = end().m_node;
-                    for (auto current = first->next; current != last; current = current->prev) {
-                        std::swap(current->prev, current->next);
-                    }
-                    std::swap(first->next, last->prev);
-                    first->next->prev = first;
-                    last->prev->next = last;
-                }
-
-                // Splices two lists together.
-                void splice(const_iterator pos, vec_list& other) {
-                    assert(this != &other);
-                    if (other.empty())
+                    if (empty())
                         return;
-
-                    // Insert other's buckets into this.
-                    this->m_buckets.insert(m_buckets.end(), std::make_move_iterator(other.m_buckets.begin()) + 1, std::make_move_iterator(other.m_buckets.end()));
-                    this->m_size += other.m_size;
-                    this->m_capacity += other.m_capacity;
-
-                    // Link the holes.
-                    link_two_nodes(this->m_last_hole, other.m_first_hole);
-                    this->m_last_hole = other.m_last_hole;
-
-                    // Link the elements to pos.
-                    auto prev = pos.m_node->prev;
-                    link_two_nodes(other.end().m_node->prev, pos.m_node);
-                    link_two_nodes(prev, other.begin().m_node);
-
-                    // Hard reset other.
-                    other = vec_list{};
-                }
-                void splice(const_iterator pos, vec_list&& other) { splice(pos, other); }
-
-                // These splice functions are not optimized like they are for std::list.
-                void splice(const_iterator pos, vec_list& other, const_iterator it) {
-                    this->insert(pos, std::move(*iterator(it.m_node)));
-                    other.erase(it);
+                    auto first = m_header->sentinel.next;
+                    auto last = m_header->sentinel.prev();
+                    for (auto l = first; l != SENTINEL_LINK; l = at(l).next)
+                        at(l).set_hole(true);
+                    at(last).next = m_header->first_hole;
+                    m_header->first_hole = first;
+                    link_two_nodes(SENTINEL_LINK, SENTINEL_LINK);
+                    m_header->size = 0;
                 }
-                void splice(const_iterator pos, vec_list&& other, const_iterator it) { splice(pos, other, it); }
 
-                void splice(const_iterator pos, vec_list& other, const_iterator first, const_iterator last) {
-                    if (first == other.begin() && last == other.end())
-                        return splice(pos, other);
-                    this->insert(pos, std::make_move_iterator(iterator(first.m_node)), std::make_move_iterator(iterator(last.m_node)));
-                    other.erase(first, last);
+                // Grows the file to fit at least new_capacity elements.
+                void reserve(size_t new_capacity) {
+                    if (new_capacity > size())
+                        resize_to_fit(new_capacity - size(), true);
                 }
-                void splice(const_iterator pos, vec_list&& other, const_iterator first, const_iterator last) { splice(pos, other, first, last); }
-
-                // Makes the list as contiguous as possible.
-                void optimize(bool shrink_to_fit) requires std::movable<T> {
-                    if (m_size == 0) {
-                        if (shrink_to_fit) {
-                            m_buckets.resize(1);
-                            m_capacity = 0;
-                        }
-                        clear();    // Clear organizes the holes.
-                        return;
-                    }
-
-                    // Sort the buckets in ascending order.
-                    std::sort(m_buckets.begin() + 1, m_buckets.end(), [](const std::vector<node>& a, const std::vector<node>& b) { return a.size() > b.size(); });
-
-                    // Find the destination buckets. Make them just large enough to contain all the points.
-                    size_t dst_capacity = 0;
-                    std::vector<std::vector<node>> dst_buckets;
-                    for (size_t i = 1; i < m_buckets.size() && dst_capacity < m_size; i++) {
-                        // Take the bucket if:
-                        // -it is below or at capacity.
-                        // -it is above capacity but the next bucket is below capacity/doesnt exist.
-                        size_t capacity_if_we_include_bucket = dst_capacity + m_buckets[i].size();
-                        bool take_bucket = (capacity_if_we_include_bucket <= m_size) || (i + 1 == m_buckets.size()) || (dst_capacity + m_buckets[i + 1].size() < m_size);
-                        if (take_bucket) {
-                            dst_capacity = capacity_if_we_include_bucket;
-                            dst_buckets.push_back(std::move(m_buckets[i]));
-                            m_buckets[i].clear(); // move is not garanteed to clear.
-                        }
-                    }
-                    assert(dst_capacity >= m_size);
+            };
+#endif
 
-                    // Copy over the elements.
-                    auto src_node = begin().m_node;
-                    auto last = end().m_node;
-                    size_t dst_bucket_index = 0;
-                    size_t dst_elem_index = 0;
-                    auto prev = src_node->prev;
-                    while (src_node != last) {
-                        // Get the dst node.
-                        assert(src_node->elem);
-                        auto dst_node = &dst_buckets[dst_bucket_index][dst_elem_index++];
-                        if (dst_elem_index == dst_buckets[dst_bucket_index].size()) {
-                            dst_elem_index = 0;
-                            dst_bucket_index++;
-                        }
-                        if (src_node != dst_node) {
-                            // Swap it with the source node and update the pointers.
-                            if (dst_node->elem) {
-                                dst_node->prev->next = src_node;
-                                dst_node->next->prev = src_node;
-                            }
-                            std::swap(*src_node, *dst_node);
-                        }
-                        link_two_nodes(prev, dst_node);
-                        prev = dst_node;
-                        src_node = dst_node->next;
-                    }
-                    link_two_nodes(prev, end().m_node);
 
-                    // Deal with unused buckets.
-                    m_first_hole = nullptr;
-                    m_last_hole = nullptr;
-                    if (shrink_to_fit) {
-                        // Remove unused buckets.
-                        m_capacity = dst_capacity;
-                        m_buckets.resize(1);
-                    }
-                    else {
-                        // Fill unused buckets with holes in reverse order so that the larger ones are used first.
-                        m_buckets.erase(std::remove_if(m_buckets.begin() + 1, m_buckets.end(), [](const std::vector<node>& bucket) { return bucket.empty(); }), m_buckets.end());
-                        for (size_t i = m_buckets.size() - 1; i > 0; i--) {
-                            fill_bucket_with_holes(i, 0);
-                        }
-                    }
+            // Erases every element which satisfies the predicate, like std::erase_if.
+            template<class T, class Links, class Allocator, class Predicate>
+            size_t erase_if(vec_list<T, Links, Allocator>& list, Predicate pred) { return list.remove_if(pred); }
 
-                    // Append the dst buckets and fill the remaining portion of the last bucket with holes.
-                    m_buckets.insert(m_buckets.end(), std::make_move_iterator(dst_buckets.begin()), std::make_move_iterator(dst_buckets.end()));
-                    if (dst_elem_index > 0)
-                        fill_bucket_with_holes(m_buckets.size() - 1, dst_elem_index);
-                }
-            };
+            template<class T, class Links, class Allocator, class U>
+            size_t erase(vec_list<T, Links, Allocator>& list, const U& value) { return list.remove_if([&](const T& elem) { return elem == value; }); }
 
 
         } // namespace vec_list_namespace
@@ -467,6 +2994,22 @@ namespace palla {
 
     // Exports.
     using details::vec_list_namespace::vec_list;
-
-
-} // namespace palla
\ No newline at end of file
+    using details::vec_list_namespace::vec_list_pool;
+#if defined(__linux__)
+    using details::vec_list_namespace::mapped_vec_list;
+#endif
+    using details::vec_list_namespace::pointer_links;
+    using details::vec_list_namespace::index_links;
+    using details::vec_list_namespace::hole_policy;
+    using details::vec_list_namespace::erase_if;
+    using details::vec_list_namespace::erase;
+
+    namespace pmr {
+        template<class T, class Links = pointer_links>
+        using vec_list = palla::vec_list<T, Links, std::pmr::polymorphic_allocator<T>>;
+        template<class T, class Links = pointer_links>
+        using vec_list_pool = palla::vec_list_pool<T, Links, std::pmr::polymorphic_allocator<T>>;
+    }
+
+
+} // namespace palla
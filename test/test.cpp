@@ -1,11 +1,20 @@
-
 #include <iostream>
 #include <random>
 #include <chrono>
 #include <list>
 #include <iomanip>
 #include <array>
-
+#include <memory>
+#include <memory_resource>
+#include <atomic>
+#include <filesystem>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <set>
+
+#define PALLA_VEC_LIST_PARALLEL
+#define PALLA_VEC_LIST_MAX_THREADS 4    // Use several threads even on a single core, so the parallel algorithms are tested.
 #include "../header/vec_list.h"
 
 // Console color codes.
@@ -117,6 +126,109 @@ void test_special_functions() {
     test_optimize(true);
     test_optimize(false);
 
+    // Test the memory statistics.
+    palla::vec_list<int> measured;
+    if (!measured.stats().buckets.empty() || measured.stats().locality != 1)
+        make_test_fail("An empty list should have no buckets.");
+    std::mt19937 stats_rng(42);
+    for (int i = 0; i < 1000; i++)
+        measured.push_back((int)stats_rng());
+    measured.remove_if([](int i) { return i % 4 == 0; });
+    auto stats = measured.stats();
+    size_t nb_elements = 0, nb_untouched = 0, nb_nodes = 0;
+    for (auto& bucket : stats.buckets) {
+        nb_elements += bucket.nb_elements;
+        nb_untouched += bucket.nb_untouched;
+        nb_nodes += bucket.capacity;
+    }
+    if (nb_elements != measured.size() || nb_nodes != measured.capacity() || stats.nb_holes != measured.capacity() - measured.size() || stats.hole_list_length + nb_untouched != stats.nb_holes || stats.hole_list_length != 1000 - measured.size())
+        make_test_fail("Incorrect memory statistics.");
+    if (stats.locality < 0.5)
+        make_test_fail("Elements pushed in order should be mostly adjacent.");
+    measured.sort();
+    if (measured.stats().locality > 0.1)
+        make_test_fail("Sorting random elements should scatter them.");
+    measured.optimize(true);
+    if (measured.stats().locality < 0.99 || measured.stats().hole_list_length != 0)
+        make_test_fail("Optimize should make the elements adjacent.");
+
+    // Test that nodes are found among thousands of small buckets, including after the buckets are reordered.
+    palla::vec_list<int> fragmented;
+    for (int i = 0; i < 2000; i++) {
+        fragmented.reserve(fragmented.size() + 16);
+        for (int j = 0; j < 16; j++)
+            fragmented.push_back(i * 16 + j);
+    }
+    for (int i = 0; i < 32000; i++) {
+        fragmented.pop_front();
+        fragmented.push_back(32000 + i);
+    }
+    fragmented.erase(fragmented.begin(), std::next(fragmented.begin(), 16000));
+    fragmented.optimize(false);
+    for (int i = 0; i < 16000; i++) {
+        fragmented.pop_front();
+        fragmented.push_back(64000 + i);
+    }
+    size_t nb_fragmented = 0;
+    fragmented.for_each_unordered([&](int) { nb_fragmented++; });
+    if (!std::ranges::equal(fragmented, std::views::iota(64000, 80000)) || nb_fragmented != fragmented.size())
+        make_test_fail("Nodes should be found among many buckets.");
+
+    // Test that nodes have no overhead beyond the two links.
+    palla::vec_list<size_t> packed_list = {0, 1};
+    auto packed_dist_bytes = (&packed_list.back() - &packed_list.front()) * sizeof(size_t);
+    if (packed_dist_bytes != 2 * sizeof(void*) + sizeof(size_t))
+        make_test_fail("Nodes should be exactly two links and an element.");
+
+    palla::vec_list<int, palla::index_links> index_list = {0, 1};
+    auto index_dist_bytes = (&index_list.back() - &index_list.front()) * sizeof(int);
+    if (index_dist_bytes != 2 * sizeof(std::uint32_t) + sizeof(int))
+        make_test_fail("Nodes with index links should be exactly two 32-bit links and an element.");
+
+    // Test that sort relinks the nodes instead of moving the elements.
+    palla::vec_list<int> unsorted = {3, 1, 2};
+    auto& three = unsorted.front();
+    unsorted.sort();
+    if (unsorted != palla::vec_list<int>{1, 2, 3} || &unsorted.back() != &three)
+        make_test_fail("Sort should relink the nodes without moving the elements.");
+
+    // Test that sorting large lists, possibly in parallel, is stable.
+    std::mt19937 rng(42);
+    std::list<std::pair<int, int>> std_pairs;
+    for (int i = 0; i < 1000000; i++)
+        std_pairs.emplace_back(rng() % 1000, i);
+    palla::vec_list<std::pair<int, int>> pairs(std_pairs.begin(), std_pairs.end());
+    palla::vec_list<std::pair<int, int>, palla::index_links> index_pairs(std_pairs.begin(), std_pairs.end());
+    auto compare_first = [](const auto& a, const auto& b) { return a.first < b.first; };
+    std_pairs.sort(compare_first);
+    pairs.sort(std::execution::par, compare_first);
+    index_pairs.sort(std::execution::par, compare_first);
+    if (!std::equal(pairs.begin(), pairs.end(), std_pairs.begin(), std_pairs.end()) || !std::equal(index_pairs.begin(), index_pairs.end(), std_pairs.begin(), std_pairs.end()))
+        make_test_fail("Parallel sort should be stable.");
+
+    // Test that only the parallel policies use other threads.
+    auto main_thread = std::this_thread::get_id();
+    std::atomic<bool> other_thread = false;
+    pairs.sort(std::execution::unseq, [&](const auto& a, const auto& b) { other_thread = other_thread || std::this_thread::get_id() != main_thread; return a.second < b.second; });
+    index_pairs.sort(std::execution::seq, [&](const auto& a, const auto& b) { other_thread = other_thread || std::this_thread::get_id() != main_thread; return a.second < b.second; });
+    if (other_thread || !std::ranges::equal(pairs, index_pairs))
+        make_test_fail("Sort should stay on the calling thread with the unseq and seq policies.");
+
+    // Test the non-member erase functions.
+    palla::vec_list<int> to_erase = {0, 1, 2, 3, 4, 5, 1};
+    if (palla::erase_if(to_erase, [](int i) { return i % 2 == 0; }) != 3 || erase(to_erase, 1) != 2 || to_erase != palla::vec_list<int>{3, 5})
+        make_test_fail("Incorrect erase_if().");
+
+    // Test that moving a list doesn't move its elements, so that vectors of lists can grow cheaply.
+    static_assert(std::is_nothrow_move_constructible_v<palla::vec_list<int>>);
+    static_assert(std::is_nothrow_move_constructible_v<palla::vec_list<int, palla::index_links>>);
+    std::vector<palla::vec_list<int>> lists(1);
+    auto first_address = &lists[0].emplace_back(42);
+    for (int i = 0; i < 100; i++)
+        lists.emplace_back();
+    if (&lists[0].front() != first_address)
+        make_test_fail("Moving a list should not move its elements.");
+
     // Test that vec_list compiles with a non-movable type and that emplace() works.
     struct non_movable {
         int val = 0;
@@ -138,6 +250,390 @@ void test_special_functions() {
     std::cout << colors::green << "PASS              " << colors::white;
 }
 
+void test_unordered_traversal() {
+    std::cout << "\nTesting unordered traversal.\n" << colors::yellow << "TESTING..." << colors::white << '\r';
+
+    // Test the unordered traversal, which scans the buckets in memory order and skips holes.
+    for (auto& list : { palla::vec_list<int>(), palla::vec_list<int>{ 3, 1, 2 } }) {
+        int nb_elems = 0;
+        list.for_each_unordered([&](int) { nb_elems++; });
+        if (nb_elems != (int)list.size() || std::ranges::distance(list.unordered_view()) != (int)list.size())
+            make_test_fail("Incorrect unordered traversal.");
+    }
+    palla::vec_list<int> scanned;
+    palla::vec_list<int, palla::index_links> index_scanned;
+    for (int i = 0; i < 1000; i++) {
+        scanned.insert(std::next(scanned.begin(), scanned.size() / 2), i);
+        index_scanned.insert(std::next(index_scanned.begin(), index_scanned.size() / 2), i);
+    }
+    scanned.remove_if([](int i) { return i % 3 == 0; });
+    index_scanned.remove_if([](int i) { return i % 3 == 0; });
+    scanned.insert(scanned.begin(), { -1, -2 });
+    index_scanned.insert(index_scanned.begin(), { -1, -2 });
+    std::vector<int> expected(scanned.begin(), scanned.end()), in_memory_order, index_in_memory_order;
+    std::ranges::sort(expected);
+    scanned.for_each_unordered([&](int& i) { in_memory_order.push_back(i); });
+    index_scanned.for_each_unordered([&](int& i) { index_in_memory_order.push_back(i); });
+    std::vector<int> from_view(std::as_const(scanned).unordered_view().begin(), std::as_const(scanned).unordered_view().end());
+    if (from_view != in_memory_order)
+        make_test_fail("unordered_view() and for_each_unordered() should visit the elements in the same order.");
+    std::ranges::sort(in_memory_order);
+    std::ranges::sort(index_in_memory_order);
+    if (in_memory_order != expected || index_in_memory_order != expected)
+        make_test_fail("Incorrect unordered traversal.");
+    scanned.optimize(false);
+    index_scanned.optimize(true);
+    in_memory_order.clear();
+    index_in_memory_order.clear();
+    scanned.for_each_unordered([&](int& i) { in_memory_order.push_back(i); });
+    std::ranges::copy(index_scanned.unordered_view(), std::back_inserter(index_in_memory_order));
+    std::ranges::sort(in_memory_order);
+    std::ranges::sort(index_in_memory_order);
+    if (in_memory_order != expected || index_in_memory_order != expected)
+        make_test_fail("Incorrect unordered traversal after optimize().");
+    scanned.clear();
+    scanned.insert(scanned.end(), { 1, 2, 3 });
+    if (std::ranges::distance(scanned.unordered_view()) != 3)
+        make_test_fail("Unordered traversal should not visit the elements erased by clear().");
+    for (auto& i : index_scanned.unordered_view())
+        i = 0;
+    if (std::ranges::count(index_scanned, 0) != (int)index_scanned.size())
+        make_test_fail("unordered_view() should give access to the elements.");
+
+    // Test the parallel unordered traversal on a list large enough to be split between threads.
+    palla::vec_list<int> entities, entities_copy;
+    palla::vec_list<int, palla::index_links> index_entities;
+    for (int i = 0; i < 1000000; i++) {
+        entities.push_back(i);
+        index_entities.push_back(i);
+    }
+    entities.remove_if([](int i) { return i % 3 == 0; });
+    index_entities.remove_if([](int i) { return i % 3 == 0; });
+    entities_copy = entities;
+    std::atomic<long long> nb_updated = 0;
+    entities.for_each_unordered(std::execution::par_unseq, [&](int& i) { i *= 2; nb_updated++; });
+    index_entities.for_each_unordered(std::execution::par, [&](int& i) { i *= 2; nb_updated++; });
+    std::as_const(entities_copy).for_each_unordered(std::execution::seq, [&](const int&) { nb_updated++; });
+    if (nb_updated != 3 * (long long)entities.size() || !std::ranges::equal(entities, index_entities) || !std::ranges::equal(entities, entities_copy, [](int a, int b) { return a == 2 * b; }))
+        make_test_fail("Incorrect parallel unordered traversal.");
+
+    // Test that the parallel policies split the list between threads, but unseq stays on the calling thread.
+    std::mutex thread_ids_mutex;
+    std::set<std::thread::id> thread_ids;
+    entities.for_each_unordered(std::execution::par, [&](int&) { std::lock_guard lock(thread_ids_mutex); thread_ids.insert(std::this_thread::get_id()); });
+    if (thread_ids.size() < 2)
+        make_test_fail("Parallel unordered traversal should use several threads.");
+    size_t nb_unseq = 0;
+    bool unseq_other_thread = false;
+    auto unseq_thread = std::this_thread::get_id();
+    index_entities.for_each_unordered(std::execution::unseq, [&](int&) { nb_unseq++; unseq_other_thread = unseq_other_thread || std::this_thread::get_id() != unseq_thread; });
+    if (unseq_other_thread || nb_unseq != index_entities.size())
+        make_test_fail("Unordered traversal should stay on the calling thread with the unseq policy.");
+
+    std::cout << colors::green << "PASS              " << colors::white;
+}
+
+// Test incremental optimization. Elements which are already among the first nodes should not move.
+template<class Links>
+void test_optimize_step_with_links() {
+    palla::vec_list<int, Links> list;
+    for (int i = 0; i < 1000; i++)
+        list.push_back(i);
+    list.remove_if([](int i) { return i % 2 == 1; });
+    auto unmoved_address = &*std::ranges::find(list, 528);  // First element of the largest bucket.
+    if (list.optimize_progress() == 1 || list.optimize_step(1))
+        make_test_fail("Optimize step should not be done in a single unit of work.");
+
+    // Modify the list between steps.
+    std::list<int> ref_list(list.begin(), list.end());
+    int nb_steps = 0;
+    while (!list.optimize_step(10)) {
+        if (nb_steps++ % 10 == 0) {
+            list.push_back(nb_steps);
+            ref_list.push_back(nb_steps);
+            list.pop_front();
+            ref_list.pop_front();
+        }
+    }
+    if (nb_steps < 10 || list.optimize_progress() != 1 || &*std::ranges::find(list, 528) != unmoved_address || !std::ranges::equal(list, ref_list))
+        make_test_fail("Incorrect incremental optimization.");
+    std::vector<int> unordered;
+    list.for_each_unordered([&](int i) { unordered.push_back(i); });
+    if (unordered.size() != list.size())
+        make_test_fail("Incremental optimization should keep the bitmaps in sync.");
+    list.insert(list.end(), 600, 42);
+    if (!std::ranges::equal(std::ranges::subrange(list.begin(), std::prev(list.end(), 600)), ref_list) || std::ranges::count(list, 42) != 600 + std::ranges::count(ref_list, 42))
+        make_test_fail("Incremental optimization should keep the holes in sync.");
+}
+
+void test_optimize_step() {
+    std::cout << "\nTesting incremental optimization.\n" << colors::yellow << "TESTING..." << colors::white << '\r';
+
+    test_optimize_step_with_links<palla::pointer_links>();
+    test_optimize_step_with_links<palla::index_links>();
+
+    std::cout << colors::green << "PASS              " << colors::white;
+}
+
+void test_hole_policies() {
+    std::cout << "\nTesting hole policies.\n" << colors::yellow << "TESTING..." << colors::white << '\r';
+
+    // Test that the nearest hole policy keeps elements inserted next to each other close in memory.
+    auto test_hole_policy = []<class Links>(Links, palla::hole_policy policy) {
+        palla::vec_list<int, Links> queue;
+        queue.set_hole_policy(policy);
+        if (queue.get_hole_policy() != policy)
+            make_test_fail("Incorrect hole policy.");
+        for (int i = 0; i < 10000; i++)
+            queue.push_back(i);
+        queue.remove_if([](int i) { return i % 2 == 1; });
+        auto capacity = queue.capacity();
+
+        // Insert the odd elements back from the end, so that the most recent holes are far from the insertion position.
+        for (auto it = queue.end(); it != queue.begin();) {
+            --it;
+            queue.insert(std::next(it), *it + 1);
+        }
+        if (queue.size() != 10000 || !std::ranges::equal(queue, std::views::iota(0, 10000)) || queue.capacity() != capacity)
+            make_test_fail("Incorrect insertion with a hole policy.");
+        return queue.stats().locality;
+    };
+    if (test_hole_policy(palla::pointer_links{}, palla::hole_policy::nearest) < 0.99 || test_hole_policy(palla::index_links{}, palla::hole_policy::nearest) < 0.99)
+        make_test_fail("The nearest hole policy should keep neighbors adjacent.");
+    if (test_hole_policy(palla::pointer_links{}, palla::hole_policy::most_recent) > 0.5)
+        make_test_fail("Incorrect test assumptions.");
+    // Test that the lowest address hole policy drains the last buckets under churn.
+    palla::vec_list<int> churned;
+    churned.set_hole_policy(palla::hole_policy::lowest_address);
+    for (int i = 0; i < 10000; i++)
+        churned.push_back(i);
+    for (int i = 0; i < 100000; i++) {
+        // Use the list as a queue of 3000 elements.
+        churned.push_front(i);
+        while (churned.size() > 3000)
+            churned.pop_back();
+    }
+    auto churned_stats = churned.stats();
+    if (churned_stats.buckets.back().nb_elements != 0 || churned_stats.buckets.front().nb_elements != churned_stats.buckets.front().capacity)
+        make_test_fail("The lowest address hole policy should fill the first buckets and drain the last ones.");
+
+    // Test that the hole policy is shared by every list of a pool.
+    palla::vec_list_pool<int> policy_pool;
+    policy_pool.set_hole_policy(palla::hole_policy::nearest);
+    if (palla::vec_list<int>(policy_pool).get_hole_policy() != palla::hole_policy::nearest)
+        make_test_fail("Lists of a pool should share its hole policy.");
+
+    std::cout << colors::green << "PASS              " << colors::white;
+}
+
+// Test that empty buckets can be freed without invalidating iterators.
+template<class Links>
+void test_release_with_links() {
+    palla::vec_list<int, Links> bursty;
+    for (int i = 0; i < 100000; i++)
+        bursty.push_back(i);
+    auto peak_capacity = bursty.capacity();
+    auto first = bursty.begin();
+    auto first_address = &bursty.front();
+    bursty.erase(std::next(bursty.begin(), 100), bursty.end());
+    if (bursty.release_empty_buckets() == 0 || bursty.capacity() > peak_capacity / 100 || first != bursty.begin() || &*first != first_address || !std::ranges::equal(bursty, std::views::iota(0, 100)))
+        make_test_fail("Empty buckets should be freed without moving any element.");
+    for (int i = 100; i < 1000; i++)
+        bursty.push_back(i);
+    if (!std::ranges::equal(bursty, std::views::iota(0, 1000)) || bursty.stats().hole_list_length != 0)
+        make_test_fail("Insertions should still work after releasing buckets.");
+
+    // Buckets can also be freed automatically, as long as enough free nodes remain.
+    bursty.set_auto_release(true, 1000);
+    for (int i = 1000; i < 100000; i++)
+        bursty.push_back(i);
+    auto grown_capacity = bursty.capacity();
+    bursty.remove_if([](int i) { return i >= 1000; });
+    if (bursty.capacity() >= grown_capacity || bursty.capacity() - bursty.size() < 1000)
+        make_test_fail("Empty buckets should be freed automatically while keeping enough free nodes.");
+    bursty.set_auto_release(true);
+    while (bursty.size() > 100)
+        bursty.pop_back();
+    if (bursty.capacity() > 1000 || &bursty.front() != first_address)
+        make_test_fail("Empty buckets should be freed automatically.");
+}
+
+void test_release() {
+    std::cout << "\nTesting releasing buckets.\n" << colors::yellow << "TESTING..." << colors::white << '\r';
+
+    test_release_with_links<palla::pointer_links>();
+    test_release_with_links<palla::index_links>();
+
+    std::cout << colors::green << "PASS              " << colors::white;
+}
+
+void test_trim() {
+    std::cout << "\nTesting trimming.\n" << colors::yellow << "TESTING..." << colors::white << '\r';
+
+    // Test that the trailing holes of the buckets can be returned to the operating system.
+    palla::vec_list<int> trimmed;
+    for (int i = 0; i < 100000; i++)
+        trimmed.push_back(i);
+    auto trimmed_capacity = trimmed.capacity();
+    auto trimmed_first = &trimmed.front();
+    trimmed.resize(100);
+    auto nb_trimmed_bytes = trimmed.trim();
+#if defined(__linux__)
+    if (nb_trimmed_bytes == 0)
+        make_test_fail("Trimming should return the pages of the trailing holes.");
+#endif
+    if (trimmed.capacity() != trimmed_capacity || &trimmed.front() != trimmed_first || !std::ranges::equal(trimmed, std::views::iota(0, 100)))
+        make_test_fail("Trimming should not move any element or change the capacity.");
+    for (int i = 100; i < 100000; i++)
+        trimmed.push_back(i);
+    if (trimmed.capacity() != trimmed_capacity || !std::ranges::equal(trimmed, std::views::iota(0, 100000)))
+        make_test_fail("Trimmed nodes should be reused.");
+
+    std::cout << colors::green << "PASS              " << colors::white;
+}
+
+void test_huge_pages() {
+    std::cout << "\nTesting huge pages.\n" << colors::yellow << "TESTING..." << colors::white << '\r';
+
+    // Test that large buckets can be mapped on huge pages.
+    palla::vec_list<int> huge;
+    huge.set_huge_pages(true);
+    for (int i = 0; i < 1000000; i++)
+        huge.push_back(i);
+    huge.erase(std::next(huge.begin(), 1000), huge.end());
+    huge.release_empty_buckets();
+    huge.optimize(true);
+    if (!huge.get_huge_pages() || !std::ranges::equal(huge, std::views::iota(0, 1000)))
+        make_test_fail("Lists with huge pages should behave like other lists.");
+
+    std::cout << colors::green << "PASS              " << colors::white;
+}
+
+// Test binary serialization. Deserializing lays the elements out in list order.
+template<class Links>
+void test_serialization_with_links() {
+    palla::vec_list<int, Links> scattered;
+    for (int i = 0; i < 10000; i++)
+        scattered.insert(std::next(scattered.begin(), scattered.size() / 2), i);
+    scattered.remove_if([](int i) { return i % 3 == 0; });
+    std::stringstream stream;
+    scattered.serialize(stream);
+    auto from_stream = palla::vec_list<int, Links>::deserialize(stream);
+    if (!std::ranges::equal(from_stream, scattered) || from_stream.capacity() != scattered.size() || from_stream.stats().locality != 1)
+        make_test_fail("Deserializing from a stream should give the same elements in a single compact bucket.");
+
+    std::vector<std::byte> buffer(scattered.serialized_size());
+    if (scattered.serialize(buffer) != buffer.size() || !std::ranges::equal(palla::vec_list<int, Links>::deserialize(buffer), scattered))
+        make_test_fail("Deserializing from a buffer should give the same elements.");
+
+    bool thrown = false;
+    try {
+        buffer.pop_back();
+        (void)palla::vec_list<int, Links>::deserialize(buffer);
+    }
+    catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    if (!thrown)
+        make_test_fail("Deserializing truncated data should throw.");
+
+    thrown = false;
+    try {
+        std::stringstream other_stream(stream.str());
+        (void)palla::vec_list<double, Links>::deserialize(other_stream);
+    }
+    catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    if (!thrown)
+        make_test_fail("Deserializing elements of another size should throw.");
+}
+
+void test_serialization() {
+    std::cout << "\nTesting serialization.\n" << colors::yellow << "TESTING..." << colors::white << '\r';
+
+    test_serialization_with_links<palla::pointer_links>();
+    test_serialization_with_links<palla::index_links>();
+
+    std::cout << colors::green << "PASS              " << colors::white;
+}
+
+void test_copy() {
+    std::cout << "\nTesting copies.\n" << colors::yellow << "TESTING..." << colors::white << '\r';
+
+    // Test that copies are laid out in list order.
+    palla::vec_list<int> shuffled;
+    for (int i = 0; i < 10000; i++)
+        shuffled.insert(std::next(shuffled.begin(), shuffled.size() / 2), i);
+    palla::vec_list<int> shuffled_copy = shuffled;
+    if (!std::ranges::equal(shuffled_copy, shuffled) || shuffled_copy.capacity() != shuffled_copy.size() || shuffled_copy.stats().locality != 1)
+        make_test_fail("A copy should have its elements in a single compact bucket.");
+    shuffled.resize(100);
+    shuffled_copy = shuffled;
+    if (!std::ranges::equal(shuffled_copy, shuffled) || shuffled_copy.capacity() != 10000 || shuffled_copy.stats().locality != 1)
+        make_test_fail("Copying into a larger list should reuse its nodes in order.");
+
+    std::cout << colors::green << "PASS              " << colors::white;
+}
+
+void test_snapshots() {
+    std::cout << "\nTesting snapshots.\n" << colors::yellow << "TESTING..." << colors::white << '\r';
+
+    // Test that snapshots don't see the modifications made after them.
+    constexpr auto has_snapshot = []<class L>(std::type_identity<L>) { return requires (L& list) { list.snapshot(); }; };
+    static_assert(!has_snapshot(std::type_identity<palla::vec_list<int>>()) && has_snapshot(std::type_identity<palla::vec_list<int, palla::index_links>>()));
+    palla::vec_list<int, palla::index_links> live;
+    for (int i = 0; i < 10000; i++)
+        live.push_back(i);
+    auto live_it = std::next(live.begin(), 10);
+    auto snapshot = live.snapshot();
+    *live_it = -1;
+    live.erase(std::next(live.begin(), 100), std::next(live.begin(), 200));
+    live.insert(live.begin(), 5, 42);
+    live.sort(std::greater<>());
+    if (*live_it != -1 || live.size() != 9905 || live.front() != 9999 || snapshot.size() != 10000 || !std::ranges::equal(snapshot, std::views::iota(0, 10000))
+        || !std::ranges::equal(snapshot | std::views::reverse, std::views::iota(0, 10000) | std::views::reverse))
+        make_test_fail("Snapshots should not change when the list is modified, and iterators of the list should stay valid.");
+    // Reading the list or moving it should never copy the buckets shared with a snapshot.
+    snapshot = live.snapshot();
+    auto live_front = &std::as_const(live).front();
+    long long live_sum = 0;
+    std::as_const(live).for_each_unordered([&](int i) { live_sum += i; });
+    (void)std::as_const(live).stats();
+    for (auto& i : std::as_const(live).unordered_view())
+        live_sum -= i;
+    auto moved_live = std::move(live);
+    if (&std::as_const(moved_live).front() != live_front || live_sum != 0 || !std::ranges::equal(std::as_const(moved_live), snapshot))
+        make_test_fail("Reading or moving a list should not copy the buckets shared with snapshots.");
+    live = std::move(moved_live);
+    live.front() = live.front();
+    if (&live.front() == live_front || !std::ranges::equal(live, snapshot))
+        make_test_fail("Modifying a list should copy the buckets shared with snapshots.");
+    auto snapshot_copy = snapshot;
+    auto snapshot_back = live.back();
+    live.clear();
+    snapshot = live.snapshot();
+    if (!snapshot.empty() || snapshot.begin() != snapshot.end() || snapshot_copy.size() != 9905 || snapshot_copy.back() != snapshot_back)
+        make_test_fail("Snapshots should be independent from each other.");
+
+    // Test that a snapshot can be read on another thread while the list is modified, and that it can outlive the list.
+    for (int i = 0; i < 100000; i++)
+        live.push_back(i);
+    snapshot = live.snapshot();
+    std::atomic<bool> snapshot_matches = false;
+    std::thread reader([&] { snapshot_matches = std::ranges::equal(snapshot, std::views::iota(0, 100000)); });
+    for (int i = 0; i < 100000; i++) {
+        live.pop_front();
+        live.push_back(i);
+    }
+    reader.join();
+    live = {};
+    if (!snapshot_matches || !std::ranges::equal(snapshot, std::views::iota(0, 100000)))
+        make_test_fail("Snapshots should be readable on another thread and outlive the list.");
+
+    std::cout << colors::green << "PASS              " << colors::white;
+}
+
 void test_comparison() {
     std::cout << "\nTesting comparisons.\n" << colors::yellow << "TESTING..." << colors::white << '\r';
 
@@ -159,11 +655,229 @@ void test_comparison() {
     std::cout << colors::green << "PASS              " << colors::white;
 }
 
-template<class T, class C, class F>
+// Memory resource which counts outstanding allocations.
+class counting_resource : public std::pmr::memory_resource {
+public:
+    size_t nb_bytes = 0;
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        nb_bytes += bytes;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+        nb_bytes -= bytes;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+};
+
+template<class Links>
+void test_allocators_with_links() {
+    counting_resource resource_a, resource_b;
+    {
+        // Empty lists should not allocate, even when moved.
+        palla::pmr::vec_list<int, Links> empty(&resource_a);
+        palla::pmr::vec_list<int, Links> moved = std::move(empty);
+        empty = std::move(moved);
+        if (resource_a.nb_bytes != 0 || empty.capacity() != 0)
+            make_test_fail("Empty lists should not allocate.");
+    }
+    {
+        // Every allocation should go through the resource.
+        palla::pmr::vec_list<int, Links> a(&resource_a);
+        for (int i = 0; i < 1000; i++)
+            a.push_back(i);
+        a.erase(std::next(a.begin(), 10), std::next(a.begin(), 500));
+        a.optimize(true);
+        if (resource_a.nb_bytes == 0 || a.get_allocator().resource() != &resource_a)
+            make_test_fail("The allocator was not used.");
+
+        // Moving to a list with a different resource should keep that resource.
+        palla::pmr::vec_list<int, Links> b(&resource_b);
+        b = std::move(a);
+        if (b.size() != 510 || b.front() != 0 || b.back() != 999 || b.get_allocator().resource() != &resource_b || resource_b.nb_bytes == 0)
+            make_test_fail("Move between different allocators should move the elements.");
+
+        // Splicing between different resources should also move the elements.
+        palla::pmr::vec_list<int, Links> c({ -2, -1 }, &resource_a);
+        b.splice(b.begin(), c);
+        if (b.size() != 512 || b.front() != -2 || !c.empty())
+            make_test_fail("Splice between different allocators should move the elements.");
+
+        // Copies should use the default resource, like other pmr containers.
+        palla::pmr::vec_list<int, Links> d = b;
+        if (d != b || d.get_allocator().resource() != std::pmr::get_default_resource())
+            make_test_fail("Copy should not propagate a polymorphic allocator.");
+    }
+    if (resource_a.nb_bytes != 0 || resource_b.nb_bytes != 0)
+        make_test_fail("Memory was leaked.");
+
+    // A monotonic buffer with no upstream must be enough for a small list.
+    std::array<std::byte, 4096> buffer;
+    std::pmr::monotonic_buffer_resource monotonic(buffer.data(), buffer.size(), std::pmr::null_memory_resource());
+    palla::pmr::vec_list<int, Links> small(&monotonic);
+    for (int i = 0; i < 100; i++)
+        small.push_front(i);
+    if (small.size() != 100 || small.front() != 99)
+        make_test_fail("Incorrect list with a monotonic buffer.");
+}
+
+void test_allocators() {
+    std::cout << "\nTesting allocators.\n" << colors::yellow << "TESTING..." << colors::white << '\r';
+
+    test_allocators_with_links<palla::pointer_links>();
+    test_allocators_with_links<palla::index_links>();
+
+    std::cout << colors::green << "PASS              " << colors::white;
+}
+
+template<class Links>
+void test_pool_with_links() {
+    // Small lists of a pool should share the same buckets.
+    palla::vec_list_pool<int, Links> pool;
+    std::vector<palla::vec_list<int, Links>> lists;
+    for (int i = 0; i < 1000; i++) {
+        auto& list = lists.emplace_back(pool);
+        for (int j = 0; j < 3; j++)
+            list.push_back(i * 3 + j);
+    }
+    if (pool.size() != 3000 || pool.capacity() < 3000 || pool.capacity() > 2 * 3000)
+        make_test_fail("Lists of a pool should share their nodes.");
+    for (int i = 0; i < 1000; i++) {
+        if (lists[i] != palla::vec_list<int, Links>{ i * 3, i * 3 + 1, i * 3 + 2 })
+            make_test_fail("Lists of a pool should not interfere with each other.");
+    }
+
+    // Erased nodes should be reused by the other lists of the pool.
+    auto capacity = pool.capacity();
+    for (int i = 0; i < 500; i++)
+        lists[i].clear();
+    for (int i = 500; i < 1000; i++)
+        lists[i].insert(lists[i].end(), { -1, -2, -3 });
+    if (pool.size() != 3000 || pool.capacity() != capacity)
+        make_test_fail("Lists of a pool should reuse each other's holes.");
+
+    // Partial splices between lists of a pool should not move any element.
+    auto& a = lists[998];
+    auto& b = lists[999];
+    std::list<int> std_a(a.begin(), a.end()), std_b(b.begin(), b.end());
+    auto first = std::next(a.begin()), last = std::prev(a.end());
+    auto first_address = &*first, last_address = &*std::prev(last);
+    b.splice(std::next(b.begin()), a, first, last);
+    std_b.splice(std::next(std_b.begin()), std_a, std::next(std_a.begin()), std::prev(std_a.end()));
+    if (!std::equal(a.begin(), a.end(), std_a.begin(), std_a.end()) || !std::equal(b.begin(), b.end(), std_b.begin(), std_b.end()) || a.size() != std_a.size() || b.size() != std_b.size())
+        make_test_fail("Incorrect splice between lists of a pool.");
+    if (&*std::next(b.begin()) != first_address || &*std::next(b.begin(), 4) != last_address)
+        make_test_fail("Splice between lists of a pool should not move the elements.");
+
+    b.splice(b.end(), a, a.begin());
+    std_b.splice(std_b.end(), std_a, std_a.begin());
+    b.splice(b.begin(), a);
+    std_b.splice(std_b.begin(), std_a);
+    if (!a.empty() || !std::equal(b.begin(), b.end(), std_b.begin(), std_b.end()) || b.size() != std_b.size())
+        make_test_fail("Incorrect splice between lists of a pool.");
+
+    // Lists of a pool can outlive it, and can splice even non-movable types.
+    struct non_movable {
+        int val = 0;
+        non_movable(int val) : val(val) {}
+        non_movable(non_movable&&) = delete;
+        non_movable& operator=(non_movable&&) = delete;
+    };
+    palla::vec_list<non_movable, Links> c, d;
+    {
+        palla::vec_list_pool<non_movable, Links> non_movable_pool;
+        palla::vec_list<non_movable, Links> e(non_movable_pool), f(non_movable_pool);
+        e.emplace_back(0);
+        e.emplace_back(1);
+        f.emplace_back(2);
+        f.splice(f.begin(), e, std::next(e.begin()));
+        c = std::move(e);
+        d = std::move(f);
+    }
+    d.emplace_back(3);
+    if (c.size() != 1 || c.front().val != 0 || d.size() != 3 || d.front().val != 1 || d.back().val != 3)
+        make_test_fail("Lists should be able to outlive their pool.");
+
+    // Partial splices between unrelated lists should move the elements and keep the buckets of each list separate.
+    palla::vec_list<non_movable, Links> g;
+    g.emplace_back(4);
+    g.emplace_back(5);
+    bool thrown = false;
+    try {
+        d.splice(d.end(), g, std::next(g.begin()), g.end());
+    }
+    catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    if (!thrown || g.size() != 2 || d.size() != 3)
+        make_test_fail("Partial splices of non-movable elements between unrelated lists should throw.");
+
+    palla::vec_list<int, Links> unrelated;
+    for (int n = 0; n < 100000; n++)
+        unrelated.push_back(n);
+    palla::vec_list<int, Links> single;
+    single.splice(single.end(), unrelated, unrelated.begin());
+    unrelated.erase(std::next(unrelated.begin(), 10), unrelated.end());
+    unrelated.optimize(true);
+    if (single.size() != 1 || single.front() != 0 || single.capacity() >= 100 || unrelated.capacity() >= 100)
+        make_test_fail("Partial splices between unrelated lists should not share their buckets.");
+
+    palla::vec_list_pool<int, Links> splice_pool;
+    palla::vec_list<int, Links> h(splice_pool), i(splice_pool);
+    for (int n = 0; n < 4; n++)
+        h.push_back(n);
+    i.push_back(4);
+    i.push_back(5);
+    auto h_address = &*std::next(h.begin());
+    i.splice(i.end(), h, std::next(h.begin()), std::prev(h.end()));
+    h.push_back(6);
+    i.splice(i.begin(), h, h.begin());
+    if (h != palla::vec_list<int, Links>{3, 6} || i != palla::vec_list<int, Links>{0, 4, 5, 1, 2} || &*std::next(i.begin(), 3) != h_address)
+        make_test_fail("Partial splices should relink the nodes.");
+
+    // Lists sharing their buckets with other lists which have elements should only visit their own elements.
+    std::vector<int> unordered_h, unordered_i;
+    h.for_each_unordered([&](int elem) { unordered_h.push_back(elem); });
+    for (int elem : i.unordered_view())
+        unordered_i.push_back(elem);
+    std::ranges::sort(unordered_i);
+    if (unordered_h != std::vector<int>{3, 6} || unordered_i != std::vector<int>{0, 1, 2, 4, 5})
+        make_test_fail("Unordered traversal should not visit the elements of other lists.");
+}
+
+void test_pool() {
+    std::cout << "\nTesting pools.\n" << colors::yellow << "TESTING..." << colors::white << '\r';
+
+    test_pool_with_links<palla::pointer_links>();
+    test_pool_with_links<palla::index_links>();
+
+    // Many small lists should use much less memory in a pool.
+    counting_resource standalone_resource, pooled_resource;
+    {
+        std::vector<palla::pmr::vec_list<int>> standalone_lists;
+        standalone_lists.reserve(1000);
+        for (int i = 0; i < 1000; i++)
+            standalone_lists.emplace_back(&standalone_resource).push_back(i);
+
+        palla::pmr::vec_list_pool<int> pool(&pooled_resource);
+        std::vector<palla::pmr::vec_list<int>> pooled_lists;
+        pooled_lists.reserve(1000);
+        for (int i = 0; i < 1000; i++)
+            pooled_lists.emplace_back(pool).push_back(i);
+
+        if (pooled_resource.nb_bytes * 4 > standalone_resource.nb_bytes)
+            make_test_fail("Lists of a pool should use less memory.");
+    }
+
+    std::cout << colors::green << "PASS              " << colors::white;
+}
+
+template<class T, class Links, class C, class F>
 void verify_vec_list_vs_std_list_stage_2(C&& compare_elements, F&& func) {
     // Apply functon both lists.
     std::list<T> std_list;
-    palla::vec_list<T> vec_list;
+    palla::vec_list<T, Links> vec_list;
 
     func(std_list);
     func(vec_list);
@@ -199,7 +913,7 @@ void verify_vec_list_vs_std_list_stage_2(C&& compare_elements, F&& func) {
         make_test_fail("Inconsistent size() and end().");
 }
 
-template<class U, class V>
+template<class Links, class U, class V>
 void verify_vec_list_vs_std_list_stage_1(U&& compare_elements, V&& create_vector) {
 
     using T = std::decay_t<decltype(create_vector()[0])>;
@@ -217,13 +931,13 @@ void verify_vec_list_vs_std_list_stage_1(U&& compare_elements, V&& create_vector
     // Constructors.
 
     // list()
-    verify_vec_list_vs_std_list_stage_2<T>(compare_elements, [&](auto& list) {
+    verify_vec_list_vs_std_list_stage_2<T, Links>(compare_elements, [&](auto& list) {
         using list_t = std::decay_t<decltype(list)>;
         list = list_t();
     });
 
     // list(it begin, it end)
-    verify_vec_list_vs_std_list_stage_2<T>(compare_elements, [&](auto& list) {
+    verify_vec_list_vs_std_list_stage_2<T, Links>(compare_elements, [&](auto& list) {
         using list_t = std::decay_t<decltype(list)>;
         auto elems = create_vector();
         if constexpr (is_copyable)
@@ -233,26 +947,26 @@ void verify_vec_list_vs_std_list_stage_1(U&& compare_elements, V&& create_vector
     });
 
     // list(size_t count)
-    verify_vec_list_vs_std_list_stage_2<T>(compare_elements, [&](auto& list) {
+    verify_vec_list_vs_std_list_stage_2<T, Links>(compare_elements, [&](auto& list) {
         using list_t = std::decay_t<decltype(list)>;
         list = list_t(10);
     });
 
     // list(list&& other)
-    verify_vec_list_vs_std_list_stage_2<T>(compare_elements, [&](auto& list) {
+    verify_vec_list_vs_std_list_stage_2<T, Links>(compare_elements, [&](auto& list) {
         auto other_list = create_list(list);
         list = std::move(other_list);
     });
 
     if constexpr (is_copyable) {
         // list(const list& other)
-        verify_vec_list_vs_std_list_stage_2<T>(compare_elements, [&](auto& list) {
+        verify_vec_list_vs_std_list_stage_2<T, Links>(compare_elements, [&](auto& list) {
             auto other_list = create_list(list);
             list = other_list;
         });
 
         // list(size_t count, const T& value)
-        verify_vec_list_vs_std_list_stage_2<T>(compare_elements, [](auto& list) {
+        verify_vec_list_vs_std_list_stage_2<T, Links>(compare_elements, [](auto& list) {
             using list_t = std::decay_t<decltype(list)>;
             list = list_t(10, T{});
         });
@@ -261,7 +975,7 @@ void verify_vec_list_vs_std_list_stage_1(U&& compare_elements, V&& create_vector
     // Insertion.
 
     // insert(const_iterator pos, it first, it last)
-    verify_vec_list_vs_std_list_stage_2<T>(compare_elements, [&](auto& list) {
+    verify_vec_list_vs_std_list_stage_2<T, Links>(compare_elements, [&](auto& list) {
         list = create_list(list);
         auto elems = create_vector();
         if constexpr (is_copyable)
@@ -271,27 +985,27 @@ void verify_vec_list_vs_std_list_stage_1(U&& compare_elements, V&& create_vector
     });
 
     // insert(const_iterator pos, T&& value)
-    verify_vec_list_vs_std_list_stage_2<T>(compare_elements, [&](auto& list) {
+    verify_vec_list_vs_std_list_stage_2<T, Links>(compare_elements, [&](auto& list) {
         list = create_list(list);
         list.insert(std::prev(list.end()), std::move(create_vector()[0]));
     });
 
     if constexpr (is_copyable) {
         // insert(const_iterator pos, const T& value)
-        verify_vec_list_vs_std_list_stage_2<T>(compare_elements, [&](auto& list) {
+        verify_vec_list_vs_std_list_stage_2<T, Links>(compare_elements, [&](auto& list) {
             list = create_list(list);
             list.insert(std::prev(list.end()), create_vector()[0]);
         });
 
         // insert(const_iterator pos, size_t count, const T& value)
-        verify_vec_list_vs_std_list_stage_2<T>(compare_elements, [&](auto& list) {
+        verify_vec_list_vs_std_list_stage_2<T, Links>(compare_elements, [&](auto& list) {
             list = create_list(list);
             list.insert(std::prev(list.end()), 10, create_vector()[0]);
         });
     }
 
     // emplace(const_iterator pos, Ts&&... args)
-    verify_vec_list_vs_std_list_stage_2<T>(compare_elements, [&](auto& list) {
+    verify_vec_list_vs_std_list_stage_2<T, Links>(compare_elements, [&](auto& list) {
         list = create_list(list);
         list.emplace(std::prev(list.end()), std::move(create_vector()[0]));
     });
@@ -299,50 +1013,50 @@ void verify_vec_list_vs_std_list_stage_1(U&& compare_elements, V&& create_vector
     // Push and pop.
 
     // emplace_back(Ts&&... args)
-    verify_vec_list_vs_std_list_stage_2<T>(compare_elements, [&](auto& list) {
+    verify_vec_list_vs_std_list_stage_2<T, Links>(compare_elements, [&](auto& list) {
         list = create_list(list);
         list.emplace_back(std::move(create_vector().front()));
     });
 
     // emplace_front(Ts&&... args)
-    verify_vec_list_vs_std_list_stage_2<T>(compare_elements, [&](auto& list) {
+    verify_vec_list_vs_std_list_stage_2<T, Links>(compare_elements, [&](auto& list) {
         list = create_list(list);
         list.emplace_front(std::move(create_vector().back()));
     });
 
     // push_back(T&& value)
-    verify_vec_list_vs_std_list_stage_2<T>(compare_elements, [&](auto& list) {
+    verify_vec_list_vs_std_list_stage_2<T, Links>(compare_elements, [&](auto& list) {
         list = create_list(list);
         list.push_back(std::move(create_vector().front()));
     });
 
     // push_front(T&& value)
-    verify_vec_list_vs_std_list_stage_2<T>(compare_elements, [&](auto& list) {
+    verify_vec_list_vs_std_list_stage_2<T, Links>(compare_elements, [&](auto& list) {
         list = create_list(list);
         list.push_front(std::move(create_vector().back()));
     });
 
     // pop_back()
-    verify_vec_list_vs_std_list_stage_2<T>(compare_elements, [&](auto& list) {
+    verify_vec_list_vs_std_list_stage_2<T, Links>(compare_elements, [&](auto& list) {
         list = create_list(list);
         list.pop_back();
     });
 
     // pop_front()
-    verify_vec_list_vs_std_list_stage_2<T>(compare_elements, [&](auto& list) {
+    verify_vec_list_vs_std_list_stage_2<T, Links>(compare_elements, [&](auto& list) {
         list = create_list(list);
         list.pop_front();
     });
 
     if constexpr (is_copyable) {
         // push_back(const T& value)
-        verify_vec_list_vs_std_list_stage_2<T>(compare_elements, [&](auto& list) {
+        verify_vec_list_vs_std_list_stage_2<T, Links>(compare_elements, [&](auto& list) {
             list = create_list(list);
             list.push_back(create_vector().front());
         });
 
         // push_front(const T& value)
-        verify_vec_list_vs_std_list_stage_2<T>(compare_elements, [&](auto& list) {
+        verify_vec_list_vs_std_list_stage_2<T, Links>(compare_elements, [&](auto& list) {
             list = create_list(list);
             list.push_front(create_vector().back());
         });
@@ -351,19 +1065,19 @@ void verify_vec_list_vs_std_list_stage_1(U&& compare_elements, V&& create_vector
     // Erase.
     
     // erase(const_iterator pos)
-    verify_vec_list_vs_std_list_stage_2<T>(compare_elements, [&](auto& list) {
+    verify_vec_list_vs_std_list_stage_2<T, Links>(compare_elements, [&](auto& list) {
         list = create_list(list);
         list.erase(std::prev(std::prev(std::prev(list.end()))));
     });
 
     // erase(const_iterator first, const_iterator last)
-    verify_vec_list_vs_std_list_stage_2<T>(compare_elements, [&](auto& list) {
+    verify_vec_list_vs_std_list_stage_2<T, Links>(compare_elements, [&](auto& list) {
         list = create_list(list);
         list.erase(std::next(std::next(list.begin())), std::prev(std::prev(list.end())));
     });
 
     // clear()
-    verify_vec_list_vs_std_list_stage_2<T>(compare_elements, [&](auto& list) {
+    verify_vec_list_vs_std_list_stage_2<T, Links>(compare_elements, [&](auto& list) {
         list = create_list(list);
         list.clear();
     });
@@ -371,70 +1085,131 @@ void verify_vec_list_vs_std_list_stage_1(U&& compare_elements, V&& create_vector
     // Resize.
 
     // resize(size_t count) (down)
-    verify_vec_list_vs_std_list_stage_2<T>(compare_elements, [&](auto& list) {
+    verify_vec_list_vs_std_list_stage_2<T, Links>(compare_elements, [&](auto& list) {
         list = create_list(list);
         list.resize(list.size() / 2);
     });
 
     // resize(size_t count) (up)
-    verify_vec_list_vs_std_list_stage_2<T>(compare_elements, [&](auto& list) {
+    verify_vec_list_vs_std_list_stage_2<T, Links>(compare_elements, [&](auto& list) {
         list = create_list(list);
         list.resize(list.size() * 2);
     });
 
     if constexpr (is_copyable) {
         // resize(size_t count, const T& value) (up).
-        verify_vec_list_vs_std_list_stage_2<T>(compare_elements, [&](auto& list) {
+        verify_vec_list_vs_std_list_stage_2<T, Links>(compare_elements, [&](auto& list) {
             list = create_list(list);
             list.resize(list.size() * 2, create_vector()[0]);
         });
     }
 
     // reverse()
-    verify_vec_list_vs_std_list_stage_2<T>(compare_elements, [&](auto& list) {
+    verify_vec_list_vs_std_list_stage_2<T, Links>(compare_elements, [&](auto& list) {
         list = create_list(list);
         list.reverse();
     });
 
+    // remove_if(Predicate pred)
+    verify_vec_list_vs_std_list_stage_2<T, Links>(compare_elements, [&](auto& list) {
+        list = create_list(list);
+        list.remove_if([i = 0](const auto&) mutable { return i++ % 3 != 1; });
+    });
+
+    // unique(BinaryPredicate pred)
+    verify_vec_list_vs_std_list_stage_2<T, Links>(compare_elements, [&](auto& list) {
+        list = create_list(list);
+        list.unique([i = 0](const auto&, const auto&) mutable { return i++ % 4 != 0; });
+    });
+
+    // merge(list other, Compare compare)
+    verify_vec_list_vs_std_list_stage_2<T, Links>(compare_elements, [&](auto& list) {
+        auto other_list = create_list(list);
+        list = create_list(list);
+        list.merge(other_list, [i = 0](const auto&, const auto&) mutable { return i++ % 3 == 0; });
+    });
+
+    if constexpr (is_copyable) {
+        // remove(const T& value)
+        verify_vec_list_vs_std_list_stage_2<T, Links>(compare_elements, [&](auto& list) {
+            list = create_list(list);
+            list.remove(*std::next(list.begin(), 2));
+        });
+
+        // unique()
+        verify_vec_list_vs_std_list_stage_2<T, Links>(compare_elements, [&](auto& list) {
+            auto other_list = create_list(list);
+            list = create_list(list);
+            list.splice(list.end(), other_list);
+            list.sort();
+            list.unique();
+        });
+
+        // merge(list other)
+        verify_vec_list_vs_std_list_stage_2<T, Links>(compare_elements, [&](auto& list) {
+            auto other_list = create_list(list);
+            list = create_list(list);
+            other_list.reverse();
+            other_list.pop_front();
+            other_list.sort();
+            list.merge(other_list);
+        });
+
+        // sort()
+        verify_vec_list_vs_std_list_stage_2<T, Links>(compare_elements, [&](auto& list) {
+            auto other_list = create_list(list);
+            list = create_list(list);
+            list.reverse();
+            list.splice(list.begin(), other_list);
+            list.sort();
+        });
+
+        // sort(Compare compare)
+        verify_vec_list_vs_std_list_stage_2<T, Links>(compare_elements, [&](auto& list) {
+            list = create_list(list);
+            list.sort(std::greater<>());
+        });
+    }
+
     // Splice.
 
     // splice(const_iterator pos, list other)
-    verify_vec_list_vs_std_list_stage_2<T>(compare_elements, [&](auto& list) {
+    verify_vec_list_vs_std_list_stage_2<T, Links>(compare_elements, [&](auto& list) {
         auto other_list = create_list(list);
         list = create_list(list);
         list.splice(std::next(std::next(list.begin())), other_list);
     });
 
     // splice(const_iterator pos, list self)
-    verify_vec_list_vs_std_list_stage_2<T>(compare_elements, [&](auto& list) {
+    verify_vec_list_vs_std_list_stage_2<T, Links>(compare_elements, [&](auto& list) {
         auto other_list = create_list(list);
         list = create_list(list);
         other_list.splice(std::next(std::next(other_list.begin())), list);
     });
 
     // splice(const_iterator pos, list other, const_iterator it)
-    verify_vec_list_vs_std_list_stage_2<T>(compare_elements, [&](auto& list) {
+    verify_vec_list_vs_std_list_stage_2<T, Links>(compare_elements, [&](auto& list) {
         auto other_list = create_list(list);
         list = create_list(list);
         list.splice(std::next(std::next(list.begin())), other_list, std::prev(std::prev(std::prev(other_list.end()))));
     });
 
     // splice(const_iterator pos, list self, const_iterator it)
-    verify_vec_list_vs_std_list_stage_2<T>(compare_elements, [&](auto& list) {
+    verify_vec_list_vs_std_list_stage_2<T, Links>(compare_elements, [&](auto& list) {
         auto other_list = create_list(list);
         list = create_list(list);
         other_list.splice(std::next(std::next(other_list.begin())), list, std::prev(std::prev(std::prev(list.end()))));
     });
 
     // splice(const_iterator pos, list other, const_iterator first, const_iterator last)
-    verify_vec_list_vs_std_list_stage_2<T>(compare_elements, [&](auto& list) {
+    verify_vec_list_vs_std_list_stage_2<T, Links>(compare_elements, [&](auto& list) {
         auto other_list = create_list(list);
         list = create_list(list);
         list.splice(std::next(std::next(list.begin())), other_list, std::next(std::next(other_list.begin())), std::prev(std::prev(std::prev(other_list.end()))));
     });
 
     // splice(const_iterator pos, list self, const_iterator first, const_iterator last)
-    verify_vec_list_vs_std_list_stage_2<T>(compare_elements, [&](auto& list) {
+    verify_vec_list_vs_std_list_stage_2<T, Links>(compare_elements, [&](auto& list) {
         auto other_list = create_list(list);
         list = create_list(list);
         other_list.splice(std::next(std::next(other_list.begin())), list, std::next(std::next(list.begin())), std::prev(std::prev(std::prev(list.end()))));
@@ -443,7 +1218,7 @@ void verify_vec_list_vs_std_list_stage_1(U&& compare_elements, V&& create_vector
 
 
     // Insert and remove lots of random elements.
-    verify_vec_list_vs_std_list_stage_2<T>(compare_elements, [&](auto& list) {
+    verify_vec_list_vs_std_list_stage_2<T, Links>(compare_elements, [&](auto& list) {
  
         constexpr size_t MAX_SIZE = 64;
         constexpr size_t NB_STEPS = 100000;
@@ -451,6 +1226,8 @@ void verify_vec_list_vs_std_list_stage_1(U&& compare_elements, V&& create_vector
 
         using it = std::decay_t<decltype(list.begin())>;
         std::vector<it> iterators;
+        auto snapshot = [&] { if constexpr (requires { list.snapshot(); }) return std::optional<decltype(list.snapshot())>(); else return 0; }();
+        std::vector<T> snapshot_elements;
 
         for (size_t i = 0; i < NB_STEPS; i++) {
 
@@ -478,6 +1255,35 @@ void verify_vec_list_vs_std_list_stage_1(U&& compare_elements, V&& create_vector
                     for (auto it = list.begin(); it != list.end(); ++it)
                         iterators.push_back(it);
                 }
+                else if (i * 100 % NB_STEPS == NB_STEPS / 2) {
+                    list.optimize_step(random_bool ? 10 : 1000);
+                    iterators.clear();
+                    for (auto it = list.begin(); it != list.end(); ++it)
+                        iterators.push_back(it);
+                }
+            }
+
+            // Switch between the hole policies.
+            if constexpr (requires { list.set_hole_policy(palla::hole_policy::nearest); }) {
+                if (i * 4 % NB_STEPS == 0) {
+                    list.set_hole_policy(palla::hole_policy(i * 4 / NB_STEPS % 3));
+                    list.set_auto_release(i * 4 / NB_STEPS % 2 == 1);
+                    list.set_huge_pages(i * 4 / NB_STEPS % 2 == 0);
+                }
+                if (i * 10 % NB_STEPS == NB_STEPS / 4)
+                    list.release_empty_buckets();
+                if (i * 10 % NB_STEPS == NB_STEPS / 2)
+                    list.trim();
+            }
+
+            // Take snapshots and check that they didn't change since.
+            if constexpr (requires { list.snapshot(); }) {
+                if (i * 20 % NB_STEPS == NB_STEPS / 4) {
+                    if (snapshot && !std::ranges::equal(*snapshot, snapshot_elements, compare_elements))
+                        make_test_fail("Snapshots should not change when the list is modified.");
+                    snapshot.emplace(list.snapshot());
+                    snapshot_elements.assign(list.begin(), list.end());
+                }
             }
 
             // Clear exactly once.
@@ -487,12 +1293,113 @@ void verify_vec_list_vs_std_list_stage_1(U&& compare_elements, V&& create_vector
     });
 }
 
+template<class U, class V>
+void verify_vec_list_vs_std_list(U&& compare_elements, V&& create_vector) {
+    verify_vec_list_vs_std_list_stage_1<palla::pointer_links>(compare_elements, create_vector);
+    verify_vec_list_vs_std_list_stage_1<palla::index_links>(compare_elements, create_vector);
+}
+
+#if defined(__linux__)
+void test_mapped() {
+    std::cout << "\nTesting mapped lists.\n" << colors::yellow << "TESTING..." << colors::white << '\r';
+
+    auto path = std::filesystem::temp_directory_path() / "vec_list_test_mapped.bin";
+    std::filesystem::remove(path);
+    std::list<int> expected;
+
+    // Fill a new file, erasing some elements so the hole list is not empty.
+    {
+        palla::mapped_vec_list<int> list(path);
+        if (!list.empty() || list.capacity() != 0)
+            make_test_fail("A new mapped list should be empty.");
+        for (int i = 0; i < 100000; i++) {
+            list.push_back(i);
+            expected.push_back(i);
+        }
+        list.erase(std::next(list.begin(), 10), std::next(list.begin(), 1000));
+        expected.erase(std::next(expected.begin(), 10), std::next(expected.begin(), 1000));
+        list.push_front(-1);
+        expected.push_front(-1);
+        list.flush();
+    }
+
+    // Reopen it and keep modifying it.
+    {
+        palla::mapped_vec_list<int> list(path);
+        if (!std::ranges::equal(list, expected))
+            make_test_fail("A reopened mapped list should have the same elements.");
+        auto capacity = list.capacity();
+        for (int i = 0; i < 500; i++) {
+            list.pop_back();
+            expected.pop_back();
+            list.emplace(std::next(list.begin(), 5), i);
+            expected.emplace(std::next(expected.begin(), 5), i);
+        }
+        if (list.capacity() != capacity)
+            make_test_fail("A mapped list should reuse its holes.");
+        auto moved = std::move(list);
+        if (!std::ranges::equal(std::views::reverse(moved), std::views::reverse(expected)))
+            make_test_fail("A mapped list should be movable.");
+    }
+    {
+        palla::mapped_vec_list<int> list(path);
+        if (!std::ranges::equal(list, expected))
+            make_test_fail("A reopened mapped list should keep every modification.");
+        list.clear();
+        list.push_back(42);
+    }
+    {
+        palla::mapped_vec_list<int> list(path);
+        if (list.size() != 1 || list.front() != 42)
+            make_test_fail("A reopened mapped list should be cleared.");
+    }
+
+    // Growing after reserve() leaves untouched nodes in an earlier bucket, which must still be used, even after reopening.
+    std::filesystem::remove(path);
+    {
+        palla::mapped_vec_list<int> list(path);
+        list.push_back(0);
+        list.reserve(100);
+        for (int i = 1; i < 150; i++)
+            list.push_back(i);
+    }
+    {
+        palla::mapped_vec_list<int> list(path);
+        for (int i = 150; i < 1000; i++)
+            list.push_back(i);
+        if (!std::ranges::equal(list, std::views::iota(0, 1000)))
+            make_test_fail("A mapped list should use the untouched nodes of every bucket.");
+    }
+
+    // Reopening a file with another element type should throw, even if it has the same size.
+    auto open_as = []<class U>(std::type_identity<U>, const std::filesystem::path& path) {
+        bool thrown = false;
+        try {
+            palla::mapped_vec_list<U> list(path);
+        }
+        catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        if (!thrown)
+            make_test_fail("Opening a mapped list with another element type should throw.");
+    };
+    open_as(std::type_identity<std::array<double, 4>>(), path);
+    open_as(std::type_identity<float>(), path);
+    open_as(std::type_identity<unsigned>(), path);
+    if (palla::mapped_vec_list<int>(path).size() != 1000)
+        make_test_fail("A mapped list should still open with its element type.");
+
+    std::filesystem::remove(path);
+    std::cout << colors::green << "PASS              " << colors::white;
+}
+#endif
+
 void test_consistency_with_std_list() {
     std::cout << "\nTesting consistency with std::list.\n" << colors::yellow << "TESTING..." << colors::white << '\r';
 
     // Test a trivial type.
     using small_trivial_t = size_t;
-    verify_vec_list_vs_std_list_stage_1([](small_trivial_t a, small_trivial_t b) { return a == b; }, []() {
+    verify_vec_list_vs_std_list([](small_trivial_t a, small_trivial_t b) { return a == b; }, []() {
         std::vector<small_trivial_t> vec(10);
         for (size_t i = 0; i < vec.size(); i++)
             vec[i] = i;
@@ -501,7 +1408,7 @@ void test_consistency_with_std_list() {
 
     // Test a very large trivial type.
     using large_trivial_t = std::array<size_t, 64>;
-    verify_vec_list_vs_std_list_stage_1([](const large_trivial_t& a, const large_trivial_t& b) { return a == b; }, []() {
+    verify_vec_list_vs_std_list([](const large_trivial_t& a, const large_trivial_t& b) { return a == b; }, []() {
         std::vector<large_trivial_t> vec(10);
         for (size_t i = 0; i < vec.size(); i++)
             vec[i][i] = i;
@@ -510,7 +1417,7 @@ void test_consistency_with_std_list() {
 
     // Test a non-trivial type.
     using non_trivial_t = std::vector<size_t>;
-    verify_vec_list_vs_std_list_stage_1([](const non_trivial_t& a, const non_trivial_t& b) { return a == b; }, []() {
+    verify_vec_list_vs_std_list([](const non_trivial_t& a, const non_trivial_t& b) { return a == b; }, []() {
         std::vector<non_trivial_t> vec(10);
         for (size_t i = 0; i < vec.size(); i++)
             vec[i].resize(i);
@@ -518,7 +1425,7 @@ void test_consistency_with_std_list() {
     });
 
     // Test a move-only type.
-    verify_vec_list_vs_std_list_stage_1([](const std::unique_ptr<size_t>& a, const std::unique_ptr<size_t>& b) { return (a == nullptr && b == nullptr) || (*a == *b); }, []() {
+    verify_vec_list_vs_std_list([](const std::unique_ptr<size_t>& a, const std::unique_ptr<size_t>& b) { return (a == nullptr && b == nullptr) || (*a == *b); }, []() {
         std::vector<std::unique_ptr<size_t>> vec(10);
         for (size_t i = 0; i < vec.size(); i++)
             vec[i] = std::make_unique<size_t>(i);
@@ -540,35 +1447,245 @@ std::chrono::duration<double> bench_insertion(int nb_elems) {
     return end - start;
 }
 
+template<class T>
+std::chrono::duration<double> bench_churn(int nb_elems) {
+    // Use the list as a queue, so every insertion reuses the node which was just erased.
+    T list;
+    for (int i = 0; i < nb_elems; i++)
+        list.push_back(i);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < nb_elems; i++) {
+        list.pop_front();
+        list.push_back(i);
+    }
+    auto end = std::chrono::steady_clock::now();
+    if (list.size() != (size_t)nb_elems || list.front() != 0)
+        make_test_fail("Incorrect churn.");
+    return end - start;
+}
+
+template<class T>
+std::chrono::duration<double> bench_clear_after_shrink(int nb_elems) {
+    // Grow the list once, then reuse it as a small scratch list.
+    constexpr int nb_rounds = 100;
+    constexpr int nb_elems_per_round = 10;
+    T list(nb_elems, 0);
+    list.clear();
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < nb_rounds; round++) {
+        for (int i = 0; i < nb_elems_per_round; i++)
+            list.push_back(i);
+        list.clear();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return end - start;
+}
+
+template<class T>
+std::chrono::duration<double> bench_sort(int nb_elems) {
+    std::mt19937 rng(42);
+    T list;
+    for (int i = 0; i < nb_elems; i++)
+        list.push_back((int)rng());
+    auto start = std::chrono::steady_clock::now();
+    list.sort();
+    auto end = std::chrono::steady_clock::now();
+    return end - start;
+}
+
+template<class T>
+std::chrono::duration<double> bench_remove_if(int nb_elems) {
+    T list;
+    for (int i = 0; i < nb_elems; i++)
+        list.push_back(i);
+    auto start = std::chrono::steady_clock::now();
+    list.remove_if([](int i) { return i % 2 == 0; });
+    auto end = std::chrono::steady_clock::now();
+    return end - start;
+}
+
+template<class T>
+std::chrono::duration<double> bench_unordered_sum(int nb_elems) {
+    // Sorting random elements scatters the nodes, so following the links jumps all over memory.
+    std::mt19937 rng(42);
+    T list;
+    for (int i = 0; i < nb_elems; i++)
+        list.push_back((int)rng());
+    list.sort();
+    long long sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    if constexpr (std::is_same_v<T, std::list<int>>) {
+        for (int i : list)
+            sum += i;
+    }
+    else {
+        list.for_each_unordered([&](int i) { sum += i; });
+    }
+    auto end = std::chrono::steady_clock::now();
+    if (sum != std::accumulate(list.begin(), list.end(), 0LL))
+        make_test_fail("Incorrect unordered sum.");
+    return end - start;
+}
+
+template<class T>
+std::chrono::duration<double> bench_sparse_sum(int nb_elems) {
+    // Only 10% of the nodes hold an element, so the scan mostly skips holes.
+    T list;
+    for (int i = 0; i < nb_elems; i++)
+        list.push_back(i);
+    list.remove_if([](int i) { return i % 10 != 0; });
+    long long sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    if constexpr (std::is_same_v<T, std::list<int>>) {
+        for (int i : list)
+            sum += i;
+    }
+    else {
+        list.for_each_unordered([&](int i) { sum += i; });
+    }
+    auto end = std::chrono::steady_clock::now();
+    if (sum != std::accumulate(list.begin(), list.end(), 0LL))
+        make_test_fail("Incorrect sparse sum.");
+    return end - start;
+}
+
+template<bool HUGE_PAGES>
+std::chrono::duration<double> bench_random_traversal(int nb_elems) {
+    // Sorting random elements scatters the nodes, so each step of the traversal lands on a random page.
+    std::mt19937 rng(42);
+    palla::vec_list<int> list;
+    list.set_huge_pages(HUGE_PAGES);
+    for (int i = 0; i < nb_elems; i++)
+        list.push_back((int)rng());
+    list.sort();
+    long long sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i : list)
+        sum += i;
+    auto end = std::chrono::steady_clock::now();
+    if (sum != std::accumulate(list.begin(), list.end(), 0LL))
+        make_test_fail("Incorrect sum with huge pages.");
+    return end - start;
+}
+
+template<class T>
+std::chrono::duration<double> bench_copy(int nb_elems) {
+    T list;
+    for (int i = 0; i < nb_elems; i++)
+        list.push_back(i);
+    auto start = std::chrono::steady_clock::now();
+    T copy = list;
+    auto end = std::chrono::steady_clock::now();
+    if (copy.size() != list.size())
+        make_test_fail("Incorrect copy.");
+    return end - start;
+}
+
+// Prints a row of a benchmark table. The fastest time is green and the slowest is red.
+void print_benchmark_row(int nb_elems, std::chrono::duration<double> std_list_time, std::chrono::duration<double> vec_list_time) {
+    constexpr double margin_of_error = 0.2;
+    constexpr int col_width = 20;
+
+    const char* std_list_color = colors::yellow;
+    const char* vec_list_color = colors::yellow;
+    if (std_list_time * (1 + margin_of_error) < vec_list_time) {
+        std_list_color = colors::green;
+        vec_list_color = colors::red;
+    }
+    else if (vec_list_time * (1 + margin_of_error) < std_list_time) {
+        std_list_color = colors::red;
+        vec_list_color = colors::green;
+    }
+
+    std::cout << std::setw(col_width) << nb_elems << "         |";
+    std::cout << std_list_color << std::setw(col_width) << std_list_time << colors::white << "         |";
+    std::cout << vec_list_color << std::setw(col_width) << vec_list_time << colors::white << '\n';
+}
+
 void test_performance() {
     std::cout << "\nBenchmark:\n";
 
     // Compare insertion speed vs std::list.
-    constexpr double margin_of_error = 0.2;
-    constexpr int col_width = 20;
     std::cout << " number of elements inserted |     time for std::list      |     time for vec_list       \n";
     std::cout << "-----------------------------|-----------------------------|-----------------------------\n";
     for (int nb_elems = 1000; nb_elems <= 10000000; nb_elems *= 10) {
         auto std_list_time = bench_insertion<std::list<int>>(nb_elems);
         auto vec_list_time = bench_insertion<palla::vec_list<int>>(nb_elems);
+        print_benchmark_row(nb_elems, std_list_time, vec_list_time);
+    }
 
-        const char* std_list_color = colors::yellow;
-        const char* vec_list_color = colors::yellow;
-        if (std_list_time * (1 + margin_of_error) < vec_list_time) {
-            std_list_color = colors::green;
-            vec_list_color = colors::red;
-        }
-        else if (vec_list_time * (1 + margin_of_error) < std_list_time) {
-            std_list_color = colors::red;
-            vec_list_color = colors::green;
-        }
+    // Compare erasing and inserting elements in a full list vs std::list.
+    std::cout << "\n number of elements churned  |     time for std::list      |     time for vec_list       \n";
+    std::cout << "-----------------------------|-----------------------------|-----------------------------\n";
+    for (int nb_elems = 1000; nb_elems <= 10000000; nb_elems *= 10) {
+        auto std_list_time = bench_churn<std::list<int>>(nb_elems);
+        auto vec_list_time = bench_churn<palla::vec_list<int>>(nb_elems);
+        print_benchmark_row(nb_elems, std_list_time, vec_list_time);
+    }
 
-        std::cout << std::setw(col_width) << nb_elems << "         |";
-        std::cout << std_list_color << std::setw(col_width) << std_list_time << colors::white << "         |";
-        std::cout << vec_list_color << std::setw(col_width) << vec_list_time << colors::white << '\n';
+    // Compare the speed of 100 rounds of filling and clearing 10 elements in a list which used to be large. This should not depend on the previous size.
+    std::cout << "\n   peak number of elements   |     time for std::list      |     time for vec_list       \n";
+    std::cout << "-----------------------------|-----------------------------|-----------------------------\n";
+    for (int nb_elems = 1000; nb_elems <= 10000000; nb_elems *= 10) {
+        auto std_list_time = bench_clear_after_shrink<std::list<int>>(nb_elems);
+        auto vec_list_time = bench_clear_after_shrink<palla::vec_list<int>>(nb_elems);
+        print_benchmark_row(nb_elems, std_list_time, vec_list_time);
+    }
+
+    // Compare copying a list vs std::list.
+    std::cout << "\n  number of elements copied  |     time for std::list      |     time for vec_list       \n";
+    std::cout << "-----------------------------|-----------------------------|-----------------------------\n";
+    for (int nb_elems = 1000; nb_elems <= 10000000; nb_elems *= 10) {
+        auto std_list_time = bench_copy<std::list<int>>(nb_elems);
+        auto vec_list_time = bench_copy<palla::vec_list<int>>(nb_elems);
+        print_benchmark_row(nb_elems, std_list_time, vec_list_time);
+    }
+
+    // Compare removing half of the elements vs std::list.
+    std::cout << "\n number of elements filtered |     time for std::list      |     time for vec_list       \n";
+    std::cout << "-----------------------------|-----------------------------|-----------------------------\n";
+    for (int nb_elems = 1000; nb_elems <= 10000000; nb_elems *= 10) {
+        auto std_list_time = bench_remove_if<std::list<int>>(nb_elems);
+        auto vec_list_time = bench_remove_if<palla::vec_list<int>>(nb_elems);
+        print_benchmark_row(nb_elems, std_list_time, vec_list_time);
+    }
+
+    // Compare sorting random elements vs std::list.
+    std::cout << "\n  number of elements sorted  |     time for std::list      |     time for vec_list       \n";
+    std::cout << "-----------------------------|-----------------------------|-----------------------------\n";
+    for (int nb_elems = 1000; nb_elems <= 1000000; nb_elems *= 10) {
+        auto std_list_time = bench_sort<std::list<int>>(nb_elems);
+        auto vec_list_time = bench_sort<palla::vec_list<int>>(nb_elems);
+        print_benchmark_row(nb_elems, std_list_time, vec_list_time);
+    }
+
+    // Compare summing scattered elements in list order with std::list vs in memory order with vec_list::for_each_unordered().
+    std::cout << "\n  number of elements summed  |     time for std::list      |     time for vec_list       \n";
+    std::cout << "-----------------------------|-----------------------------|-----------------------------\n";
+    for (int nb_elems = 1000; nb_elems <= 10000000; nb_elems *= 10) {
+        auto std_list_time = bench_unordered_sum<std::list<int>>(nb_elems);
+        auto vec_list_time = bench_unordered_sum<palla::vec_list<int>>(nb_elems);
+        print_benchmark_row(nb_elems, std_list_time, vec_list_time);
     }
-}
 
+    // Compare summing a list where 90% of the nodes have been erased. The number of elements is before the erasure.
+    std::cout << "\n  number of nodes scanned    |     time for std::list      |     time for vec_list       \n";
+    std::cout << "-----------------------------|-----------------------------|-----------------------------\n";
+    for (int nb_elems = 1000; nb_elems <= 10000000; nb_elems *= 10) {
+        auto std_list_time = bench_sparse_sum<std::list<int>>(nb_elems);
+        auto vec_list_time = bench_sparse_sum<palla::vec_list<int>>(nb_elems);
+        print_benchmark_row(nb_elems, std_list_time, vec_list_time);
+    }
+
+    // Compare following the links of a shuffled vec_list with and without huge pages. This is where TLB misses dominate.
+    std::cout << "\n number of nodes traversed   |  time without huge pages    |   time with huge pages      \n";
+    std::cout << "-----------------------------|-----------------------------|-----------------------------\n";
+    for (int nb_elems = 1000; nb_elems <= 10000000; nb_elems *= 10) {
+        auto regular_time = bench_random_traversal<false>(nb_elems);
+        auto huge_pages_time = bench_random_traversal<true>(nb_elems);
+        print_benchmark_row(nb_elems, regular_time, huge_pages_time);
+    }
+}
 
 
 int main() {
@@ -576,7 +1693,21 @@ int main() {
     std::cout << colors::white;
 
     test_special_functions();
+    test_unordered_traversal();
+    test_optimize_step();
+    test_hole_policies();
+    test_release();
+    test_trim();
+    test_huge_pages();
+    test_serialization();
+    test_copy();
+    test_snapshots();
     test_comparison();
+    test_allocators();
+    test_pool();
+#if defined(__linux__)
+    test_mapped();
+#endif
     test_consistency_with_std_list();
 
     std::cout << "\n\nGlobal Result: " << colors::green << "PASS" << colors::white << "\n";